@@ -4,6 +4,7 @@
 
 #include <sys/socket.h>
 #include <unistd.h>                 // close
+#include <cstring>                  // memset
 
 static int createNonblocking()
 {
@@ -41,6 +42,18 @@ void Acceptor::listenFd()
     acceptChannel_.enableReading();
 }
 
+InetAddress Acceptor::listenAddress() const
+{
+    sockaddr_in local;
+    memset(&local, 0x00, sizeof(local));
+    socklen_t addrlen = sizeof(local);
+    if (getsockname(acceptSocket_.fd(), (sockaddr*)&local, &addrlen) < 0)
+    {
+        LOG_ERROR("%s:%s:%d getsockname错误，errno:%d\n", __FILE__, __func__, __LINE__, errno);
+    }
+    return InetAddress(local);
+}
+
 void Acceptor::handleRead()
 {
     InetAddress peeraddr;
@@ -3,11 +3,11 @@
 #include "nonmoveable.h"
 #include "Socket.h"
 #include "Channel.h"
+#include "InetAddress.h"
 
 #include <functional>
 
 class EventLoop;
-class InetAddress;
 
 class Acceptor : private noncopyable, private nonmoveable
 {
@@ -19,6 +19,8 @@ public:
     void setNewConnectionCallback(const NewConnectionCallback& cb) { newConnectionCallback_ = cb; }
     bool listenning() const { return listenning_; }
     void listenFd();
+    // 实际绑定的地址：监听端口为0时由内核分配
+    InetAddress listenAddress() const;
 private:
     void handleRead();
 
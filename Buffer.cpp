@@ -6,6 +6,11 @@
 
 ssize_t Buffer::readFd(int fd, int* saveErrno)
 {
+    // 使用内存池的缓冲区还没有存储时先取一块最小的，数据直接读进去
+    if (pool_ != nullptr && data_ == nullptr)
+    {
+        ensureWriteableBytes(BufferPool::kMinClassSize - kCheapPrepend);
+    }
     char extrabuf[65536] = {0};
 
     struct iovec vec[2];
@@ -31,6 +36,11 @@ ssize_t Buffer::readFd(int fd, int* saveErrno)
         writerIndex_ += writableSize;
         append(extrabuf, n - writableSize);
     }
+    // 没有读到数据（对端关闭、EAGAIN）时刚取的存储还回去
+    if (pool_ != nullptr && readableBytes() == 0)
+    {
+        releaseStorage();
+    }
 
     return n;
 }
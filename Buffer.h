@@ -1,8 +1,9 @@
 #pragma once
+#include "BufferPool.h"
 
 #include <vector>
 #include <string>
-#include <algorithm>
+#include <algorithm>            // copy、max
 
 // 网络库底层的缓冲器类型定义
 class Buffer
@@ -12,11 +13,27 @@ public:
     static const size_t kInitialSize = 1024;
 
     explicit Buffer(size_t initialSize = kInitialSize)
-        : buffer_(kCheapPrepend + initialSize)
+        : data_(new char[kCheapPrepend + initialSize])
+        , capacity_(kCheapPrepend + initialSize)
+        , pool_(nullptr)
         , readerIndex_(kCheapPrepend)
         , writerIndex_(kCheapPrepend)
     {}
 
+    // 存储来自所属loop的内存池：第一次写入时才分配，数据全部取完后还给池；没有存储时读写下标都是0
+    explicit Buffer(BufferPool* pool)
+        : data_(nullptr)
+        , capacity_(0)
+        , pool_(pool)
+        , readerIndex_(0)
+        , writerIndex_(0)
+    {}
+
+    ~Buffer() { releaseStorage(); }
+
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+
     size_t readableBytes() const 
     {
         return writerIndex_ - readerIndex_;
@@ -24,7 +41,7 @@ public:
 
     size_t writableBytes() const
     {
-        return buffer_.size() - writerIndex_;
+        return capacity_ > writerIndex_ ? capacity_ - writerIndex_ : 0;
     }
 
     size_t prependableBytes() const
@@ -54,6 +71,11 @@ public:
     void retrieveAll()
     {
         readerIndex_ = writerIndex_ = kCheapPrepend;
+        // 使用内存池时排空就归还存储，突发流量撑大的缓冲区不会一直留在这个链接上
+        if (pool_ != nullptr)
+        {
+            releaseStorage();
+        }
     }
 
     // 把onMessage函数上报的Buffer数据，转成string类型的数据返回
@@ -96,25 +118,57 @@ public:
         return begin() + writerIndex_;
     }
 
+    void swap(Buffer& rhs)
+    {
+        std::swap(data_, rhs.data_);
+        std::swap(capacity_, rhs.capacity_);
+        std::swap(pool_, rhs.pool_);
+        std::swap(readerIndex_, rhs.readerIndex_);
+        std::swap(writerIndex_, rhs.writerIndex_);
+    }
+
     // 从fd上读取数据
     ssize_t readFd(int fd, int* saveErrno);
     // 通过fd发送数据
     ssize_t writeFd(int fd, int* saveErrno);
 private:
+    // 还没有分配存储时为空，此时读写下标都是0，peek()/beginWrite()返回空指针
     char* begin()
     {
-        // it.operator*()
-        return &*buffer_.begin();  // vector底层数组首元素的地址，也就是数组的起始地址
+        return data_;
     }
     const char* begin() const
     {
-        return &*buffer_.begin();
+        return data_;
     }
     void makeSpace(size_t len)
     {
-        if (writableBytes() + prependableBytes() < len + kCheapPrepend)
+        if (writableBytes() + prependableBytes() < len + kCheapPrepend || data_ == nullptr)
         {
-            buffer_.resize(writerIndex_ + len);
+            size_t readable = readableBytes();
+            if (pool_ == nullptr)
+            {
+                // 至少翻倍增长：数据一直不取走时连续append的总拷贝量是线性的
+                size_t capacity = std::max(2 * capacity_, writerIndex_ + len);
+                char* data = new char[capacity];
+                std::copy(begin() + readerIndex_, begin() + writerIndex_, data + readerIndex_);
+                delete[] data_;
+                data_ = data;
+                capacity_ = capacity;
+                return;
+            }
+            // 从池中换一块更大的存储，只搬动可读数据；同样至少翻倍
+            size_t capacity = 0;
+            char* data = pool_->allocate(std::max(2 * capacity_, kCheapPrepend + readable + len), &capacity);
+            if (data_ != nullptr)
+            {
+                std::copy(begin() + readerIndex_, begin() + writerIndex_, data + kCheapPrepend);
+            }
+            releaseStorage();
+            data_ = data;
+            capacity_ = capacity;
+            readerIndex_ = kCheapPrepend;
+            writerIndex_ = readerIndex_ + readable;
         }
         else
         {
@@ -126,8 +180,29 @@ private:
             writerIndex_ = readerIndex_ + readalbe;
         }
     }
+    void releaseStorage()
+    {
+        if (data_ == nullptr)
+        {
+            return;
+        }
+        if (pool_ != nullptr)
+        {
+            pool_->deallocate(data_, capacity_);
+        }
+        else
+        {
+            delete[] data_;
+        }
+        data_ = nullptr;
+        capacity_ = 0;
+        readerIndex_ = writerIndex_ = 0;
+    }
 
-    std::vector<char> buffer_;
+    char* data_;
+    size_t capacity_;
+    // 为空时存储由自己new/delete，和原来的vector一样只增长不归还
+    BufferPool* pool_;
     size_t readerIndex_;
     size_t writerIndex_;
 };
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "BufferPool.h"
+#include "EventLoop.h"
+#include "CurrentThread.h"
+
+#include <algorithm>            // min
+#include <new>                  // operator new/delete
+
+
+BufferPool::BufferPool(EventLoop* loop, double trimIntervalSeconds)
+    : loop_(loop)
+    , trimIntervalSeconds_(trimIntervalSeconds)
+    , ownerTid_(CurrentThread::tid())
+    , lowWater_()
+    , cachedBytes_(0)
+    , trimScheduled_(false)
+    , systemAllocations_(0)
+    , reuses_(0)
+    , trimmedBytes_(0) {}
+
+BufferPool::~BufferPool()
+{
+    detach();
+}
+
+void BufferPool::detach()
+{
+    // 回收定时器的回调持有this
+    if (trimScheduled_)
+    {
+        trimScheduled_ = false;
+        loop_->cancel(trimTimer_);
+    }
+    for (auto& list : freeLists_)
+    {
+        for (char* data : list)
+        {
+            ::operator delete(data);
+        }
+        std::vector<char*>().swap(list);
+    }
+    cachedBytes_ = 0;
+    ownerTid_.store(0, std::memory_order_relaxed);
+    loop_ = nullptr;
+}
+
+int BufferPool::sizeClass(size_t size)
+{
+    int cls = 0;
+    while (cls < kNumClasses && classSize(cls) < size)
+    {
+        ++cls;
+    }
+    return cls < kNumClasses ? cls : -1;
+}
+
+bool BufferPool::inOwnerThread() const
+{
+    return CurrentThread::tid() == ownerTid_.load(std::memory_order_relaxed);
+}
+
+char* BufferPool::allocate(size_t size, size_t* capacity)
+{
+    int cls = sizeClass(size);
+    if (cls < 0)
+    {
+        // 不缓存的大块按2的幂取整，调用方逐步增长时重新分配的次数是对数级的
+        size_t rounded = kMaxClassSize;
+        while (rounded < size)
+        {
+            rounded *= 2;
+        }
+        *capacity = rounded;
+        return static_cast<char*>(::operator new(rounded));
+    }
+    *capacity = classSize(cls);
+    if (inOwnerThread())
+    {
+        std::vector<char*>& list = freeLists_[cls];
+        if (!list.empty())
+        {
+            char* data = list.back();
+            list.pop_back();
+            cachedBytes_ -= *capacity;
+            lowWater_[cls] = std::min(lowWater_[cls], list.size());
+            ++reuses_;
+            return data;
+        }
+        ++systemAllocations_;
+    }
+    return static_cast<char*>(::operator new(*capacity));
+}
+
+void BufferPool::deallocate(char* data, size_t capacity)
+{
+    int cls = sizeClass(capacity);
+    if (cls < 0 || classSize(cls) != capacity || !inOwnerThread() || (freeLists_[cls].size() + 1) * capacity > kMaxCachedBytesPerClass)
+    {
+        ::operator delete(data);
+        return;
+    }
+    freeLists_[cls].push_back(data);
+    cachedBytes_ += capacity;
+    scheduleTrim();
+}
+
+void BufferPool::scheduleTrim()
+{
+    if (trimScheduled_ || trimIntervalSeconds_ <= 0)
+    {
+        return;
+    }
+    trimScheduled_ = true;
+    // 新缓存的块要等一个完整的周期才会被回收
+    for (int cls = 0; cls < kNumClasses; ++cls)
+    {
+        lowWater_[cls] = freeLists_[cls].size();
+    }
+    trimTimer_ = loop_->runAfter(trimIntervalSeconds_, [this]() {
+        trimScheduled_ = false;
+        trim();
+        if (cachedBytes_ > 0)
+        {
+            scheduleTrim();
+        }
+    });
+}
+
+void BufferPool::trim()
+{
+    for (int cls = 0; cls < kNumClasses; ++cls)
+    {
+        std::vector<char*>& list = freeLists_[cls];
+        // 整个周期都没有被取用的块从链表头部释放，最近还回来的块留在尾部继续复用
+        size_t idle = std::min(lowWater_[cls], list.size());
+        for (size_t i = 0; i < idle; ++i)
+        {
+            ::operator delete(list[i]);
+        }
+        list.erase(list.begin(), list.begin() + idle);
+        cachedBytes_ -= idle * classSize(cls);
+        trimmedBytes_ += idle * classSize(cls);
+        lowWater_[cls] = list.size();
+        if (list.empty())
+        {
+            // 突发之后链表的容量也还回去
+            std::vector<char*>().swap(list);
+        }
+    }
+}
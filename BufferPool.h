@@ -0,0 +1,73 @@
+#pragma once
+#include "noncopyable.h"
+#include "nonmoveable.h"
+#include "TimerId.h"
+
+#include <vector>
+#include <atomic>
+#include <cstddef>              // size_t
+#include <cstdint>              // uint64_t
+#include <sys/types.h>          // pid_t
+
+class EventLoop;
+
+
+/*
+每个EventLoop持有一个缓冲区内存池（EventLoop::bufferPool()），TcpConnection的Buffer和ChainBuffer都从这里取存储：
+1. 按1KB、2KB、...、64KB分级，空闲的存储挂在对应级别的空闲链表上；更大的请求按2的幂取整后直接向系统申请，释放时直接归还
+2. 缓冲区第一次用到时才从池中取存储，数据取完就还回来：空闲的链接不占缓冲区内存，
+   突发流量把某个链接的缓冲区撑到几MB，排空之后也会归还，而不是一直留在这个链接上
+3. 空闲链表定期回收：上一个周期内一直没有被取用的存储还给系统，常驻内存跟着活跃的数据走，而不是每个链接历史上的峰值；
+   池中没有缓存时不启动回收定时器
+空闲链表只在所属loop线程中访问；在其他线程（例如链接在baseLoop中析构）分配和释放直接走系统，不需要加锁
+EventLoop和它的链接共同持有内存池（shared_ptr）：loop析构时调用detach，之后链接释放存储直接还给系统，不依赖loop还活着
+*/
+class BufferPool : private noncopyable, private nonmoveable
+{
+public:
+    static constexpr size_t kMinClassSize = 1024;
+    static constexpr int kNumClasses = 7;
+    static constexpr size_t kMaxClassSize = kMinClassSize << (kNumClasses - 1);
+    // 每级最多缓存的字节数，超过的部分释放时直接还给系统
+    static constexpr size_t kMaxCachedBytesPerClass = 2 * 1024 * 1024;
+
+    // 在loop所在线程中构造；trimIntervalSeconds是回收周期
+    explicit BufferPool(EventLoop* loop, double trimIntervalSeconds = 1.0);
+    ~BufferPool();
+
+    // 返回至少size字节的存储，实际大小写入*capacity，释放时原样传回
+    char* allocate(size_t size, size_t* capacity);
+    void deallocate(char* data, size_t capacity);
+    // 把上一次回收以来一直空闲的存储还给系统，回收定时器调用，也可以手动调用
+    void trim();
+    // loop析构时在loop线程中调用：取消回收定时器、释放缓存，之后任何线程的分配和释放都直接走系统
+    void detach();
+
+    // 池中缓存的字节数、向系统申请的次数、从池中复用的次数、回收还给系统的字节数，只能在loop线程中读取
+    size_t cachedBytes() const { return cachedBytes_; }
+    uint64_t systemAllocations() const { return systemAllocations_; }
+    uint64_t reuses() const { return reuses_; }
+    uint64_t trimmedBytes() const { return trimmedBytes_; }
+
+private:
+    // size所在的级别，超过kMaxClassSize返回-1
+    static int sizeClass(size_t size);
+    static size_t classSize(int cls) { return kMinClassSize << cls; }
+    bool inOwnerThread() const;
+    void scheduleTrim();
+
+    // detach之后为空
+    EventLoop* loop_;
+    const double trimIntervalSeconds_;
+    // detach之后为0，不会和任何线程匹配；其他线程析构链接时可能同时读取
+    std::atomic<pid_t> ownerTid_;
+    std::vector<char*> freeLists_[kNumClasses];
+    // 上一次回收以来每级空闲链表的最短长度：这么多块整个周期都没有被取用
+    size_t lowWater_[kNumClasses];
+    size_t cachedBytes_;
+    bool trimScheduled_;
+    TimerId trimTimer_;
+    uint64_t systemAllocations_;
+    uint64_t reuses_;
+    uint64_t trimmedBytes_;
+};
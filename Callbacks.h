@@ -1,4 +1,5 @@
 #pragma once
+#include "InplaceFunction.h"
 
 #include <memory>
 #include <functional>
@@ -13,4 +14,6 @@ using ConnectionCallback = std::function<void(const TcpConnectionPtr&)>;
 using CloseCallback = std::function<void(const TcpConnectionPtr&)>;
 using WriteCompleteCallback = std::function<void(const TcpConnectionPtr&)>;
 using MessageCallback = std::function<void(const TcpConnectionPtr&, Buffer*, Timestamp)>;
-using HighWaterMarkCallback = std::function<void(const TcpConnectionPtr&, size_t)>;
\ No newline at end of file
+using HighWaterMarkCallback = std::function<void(const TcpConnectionPtr&, size_t)>;
+// 定时器回调只会被TimerQueue持有一次，使用只能移动的InplaceFunction，添加定时器不分配回调的内存
+using TimerCallback = InplaceFunction<void()>;
@@ -0,0 +1,210 @@
+#include "ChainBuffer.h"
+
+#include <algorithm>            // min
+#include <cstring>              // memcpy
+#include <sys/uio.h>            // iovec、readv、writev
+#include <errno.h>
+
+
+ChainBuffer::~ChainBuffer()
+{
+    retrieveAll();
+    delete[] spare_;
+}
+
+ChainBuffer::Block ChainBuffer::newBlock()
+{
+    Block block;
+    block.readIndex = 0;
+    block.writeIndex = 0;
+    if (pool_ != nullptr)
+    {
+        size_t capacity = 0;
+        block.data = pool_->allocate(kBlockSize, &capacity);
+    }
+    else if (spare_ != nullptr)
+    {
+        block.data = spare_;
+        spare_ = nullptr;
+    }
+    else
+    {
+        block.data = new char[kBlockSize];
+    }
+    return block;
+}
+
+void ChainBuffer::freeBlock(const Block& block)
+{
+    if (pool_ != nullptr)
+    {
+        pool_->deallocate(block.data, kBlockSize);
+    }
+    else if (spare_ == nullptr)
+    {
+        spare_ = block.data;
+    }
+    else
+    {
+        delete[] block.data;
+    }
+}
+
+void ChainBuffer::retrieve(size_t len)
+{
+    if (len >= readable_)
+    {
+        retrieveAll();
+        return;
+    }
+    readable_ -= len;
+    while (len > 0)
+    {
+        Block& front = blocks_.front();
+        size_t n = front.writeIndex - front.readIndex;
+        if (len < n)
+        {
+            front.readIndex += len;
+            return;
+        }
+        // 整块读完直接释放，剩下的数据不动
+        len -= n;
+        freeBlock(front);
+        blocks_.pop_front();
+    }
+}
+
+void ChainBuffer::retrieveAll()
+{
+    for (const Block& block : blocks_)
+    {
+        freeBlock(block);
+    }
+    blocks_.clear();
+    readable_ = 0;
+}
+
+std::string ChainBuffer::retrieveAsString(size_t len)
+{
+    len = std::min(len, readable_);
+    std::string result;
+    result.reserve(len);
+    size_t left = len;
+    for (const Block& block : blocks_)
+    {
+        if (left == 0)
+        {
+            break;
+        }
+        size_t n = std::min(left, block.writeIndex - block.readIndex);
+        result.append(block.data + block.readIndex, n);
+        left -= n;
+    }
+    retrieve(len);
+    return result;
+}
+
+void ChainBuffer::append(const char* data, size_t len)
+{
+    readable_ += len;
+    while (len > 0)
+    {
+        if (blocks_.empty() || blocks_.back().writeIndex == kBlockSize)
+        {
+            blocks_.push_back(newBlock());
+        }
+        Block& back = blocks_.back();
+        size_t n = std::min(len, kBlockSize - back.writeIndex);
+        memcpy(back.data + back.writeIndex, data, n);
+        back.writeIndex += n;
+        data += n;
+        len -= n;
+    }
+}
+
+void ChainBuffer::swap(ChainBuffer& rhs)
+{
+    blocks_.swap(rhs.blocks_);
+    std::swap(readable_, rhs.readable_);
+    std::swap(pool_, rhs.pool_);
+    std::swap(spare_, rhs.spare_);
+}
+
+ssize_t ChainBuffer::readFd(int fd, int* saveErrno)
+{
+    // 尾块剩下的空间加上新块，凑够kMaxReadBytes；没有用到的新块读完之后释放
+    constexpr int kMaxIov = static_cast<int>(kMaxReadBytes / kBlockSize) + 1;
+    struct iovec vec[kMaxIov];
+    Block fresh[kMaxIov];
+    int iovcnt = 0;
+    int freshCount = 0;
+    size_t capacity = 0;
+    Block* tail = nullptr;
+    if (!blocks_.empty() && blocks_.back().writeIndex < kBlockSize)
+    {
+        tail = &blocks_.back();
+        vec[iovcnt].iov_base = tail->data + tail->writeIndex;
+        vec[iovcnt].iov_len = kBlockSize - tail->writeIndex;
+        capacity += vec[iovcnt].iov_len;
+        ++iovcnt;
+    }
+    while (capacity < kMaxReadBytes && iovcnt < kMaxIov)
+    {
+        fresh[freshCount] = newBlock();
+        vec[iovcnt].iov_base = fresh[freshCount].data;
+        vec[iovcnt].iov_len = kBlockSize;
+        capacity += kBlockSize;
+        ++freshCount;
+        ++iovcnt;
+    }
+
+    const ssize_t n = readv(fd, vec, iovcnt);
+    if (n < 0)
+    {
+        *saveErrno = errno;
+    }
+    size_t left = n > 0 ? static_cast<size_t>(n) : 0;
+    readable_ += left;
+    if (tail != nullptr)
+    {
+        size_t used = std::min(left, kBlockSize - tail->writeIndex);
+        tail->writeIndex += used;
+        left -= used;
+    }
+    for (int i = 0; i < freshCount; ++i)
+    {
+        if (left > 0)
+        {
+            fresh[i].writeIndex = std::min(left, kBlockSize);
+            left -= fresh[i].writeIndex;
+            blocks_.push_back(fresh[i]);
+        }
+        else
+        {
+            freeBlock(fresh[i]);
+        }
+    }
+    return n;
+}
+
+ssize_t ChainBuffer::writeFd(int fd, int* saveErrno)
+{
+    struct iovec vec[kMaxWriteBlocks];
+    int iovcnt = 0;
+    for (const Block& block : blocks_)
+    {
+        if (iovcnt == kMaxWriteBlocks)
+        {
+            break;
+        }
+        vec[iovcnt].iov_base = block.data + block.readIndex;
+        vec[iovcnt].iov_len = block.writeIndex - block.readIndex;
+        ++iovcnt;
+    }
+    ssize_t n = writev(fd, vec, iovcnt);
+    if (n < 0)
+    {
+        *saveErrno = errno;
+    }
+    return n;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "noncopyable.h"
+#include "BufferPool.h"
+
+#include <deque>
+#include <string>
+#include <sys/types.h>          // ssize_t
+
+
+/*
+分段缓冲区：由固定大小的块串成，用作TcpConnection的发送缓冲区
+1. append只往尾块写，写满了接一个新块，已有的数据从不搬动：Buffer的makeSpace要么resize拷贝全部数据，要么把可读数据memmove到头部，
+   积压几MB的发送缓冲区每次增长都是O(n)
+2. retrieve把读完的块整块释放，不需要搬动剩下的数据
+3. writeFd用writev一次发送多个块，readFd用readv直接读进尾块和新块，没有中转的栈缓冲区
+4. 块的地址在释放前不变，完成模式提交给内核的数据在发送期间可以继续append
+5. 指定内存池时块从池中分配、读完就还回池中；没有内存池时自己new/delete，并保留一个空块
+只有第一个块中的数据是连续的：peek()/contiguousBytes()返回这一段；需要整段连续数据的场景（解析输入）仍然使用Buffer
+*/
+class ChainBuffer : private noncopyable
+{
+public:
+    static constexpr size_t kBlockSize = 16 * 1024;
+    // 一次writev最多发送的块数
+    static constexpr int kMaxWriteBlocks = 64;
+    // 一次readv最多读取的字节数，尾块不够时补上新块
+    static constexpr size_t kMaxReadBytes = 64 * 1024;
+
+    explicit ChainBuffer(BufferPool* pool = nullptr) : readable_(0), pool_(pool), spare_(nullptr) {}
+    ~ChainBuffer();
+
+    size_t readableBytes() const { return readable_; }
+    // 当前持有的数据块数，不包括缓存的空块
+    size_t numBlocks() const { return blocks_.size(); }
+
+    // 第一个块中的可读数据，缓冲区为空时返回nullptr
+    const char* peek() const { return blocks_.empty() ? nullptr : blocks_.front().data + blocks_.front().readIndex; }
+    size_t contiguousBytes() const { return blocks_.empty() ? 0 : blocks_.front().writeIndex - blocks_.front().readIndex; }
+
+    void retrieve(size_t len);
+    void retrieveAll();
+    std::string retrieveAsString(size_t len);
+    std::string retrieveAllAsString() { return retrieveAsString(readableBytes()); }
+
+    void append(const char* data, size_t len);
+
+    void swap(ChainBuffer& rhs);
+
+    // 从fd上读取数据
+    ssize_t readFd(int fd, int* saveErrno);
+    // 通过fd发送数据，和Buffer一样不取走数据，由调用者retrieve
+    ssize_t writeFd(int fd, int* saveErrno);
+
+private:
+    // 块的存储固定kBlockSize字节，从内存池分配时正好落在16KB这一级
+    struct Block
+    {
+        char* data;
+        size_t readIndex;
+        size_t writeIndex;
+    };
+
+    Block newBlock();
+    void freeBlock(const Block& block);
+
+    std::deque<Block> blocks_;
+    size_t readable_;
+    BufferPool* pool_;
+    // 没有内存池时保留一个空块的存储：发送缓冲区反复在空和非空之间切换时不用每次都分配
+    char* spare_;
+};
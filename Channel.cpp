@@ -9,6 +9,7 @@ Channel::Channel(EventLoop* loop, int fd)
     , events_(0)
     , revents_(0)
     , index_(-1)
+    , edgeTriggered_(false)
     , tied_(false) {}
 
 void Channel::handleEvent(Timestamp receiveTime) 
@@ -64,23 +65,32 @@ void Channel::handleEventWithGuard(Timestamp receiveTime)
     第一次事件循环：revents = EPOLLIN | EPOLLHUP，所以先去读FIN报文，muduo是LT模式，EPOLLHUB没有处理还会继续通知
     第二次事件循环：revents = EPOLLHUP 进行链接的关闭操作
     */
+    // beginActivity/endActivity：给卡顿检测记录正在执行哪个回调，没有开启检测时只是一次判断
     if ((revents_ & EPOLLHUP) && !(revents_ & EPOLLIN)) 
     {
+        loop_->beginActivity(this, LoopActivity::kClose);
         if (closeCallback_) closeCallback_();
+        loop_->endActivity();
     }
 
     if (revents_ & EPOLLERR) 
     {
+        loop_->beginActivity(this, LoopActivity::kError);
         if (errorCallback_) errorCallback_();
+        loop_->endActivity();
     }
 
     if (revents_ & (EPOLLIN | EPOLLPRI)) 
     {
+        loop_->beginActivity(this, LoopActivity::kRead);
         if (readCallback_) readCallback_(receiveTime);
+        loop_->endActivity();
     }
 
     if (revents_ & EPOLLOUT) 
     {
+        loop_->beginActivity(this, LoopActivity::kWrite);
         if (writeCallback_) writeCallback_();
+        loop_->endActivity();
     }
 }
\ No newline at end of file
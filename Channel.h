@@ -2,8 +2,10 @@
 #include "noncopyable.h"
 #include "nonmoveable.h"
 #include "Timestamp.h"
+#include "InplaceFunction.h"
 
 #include <functional>               // function
+#include <string>
 #include <memory>                   // shared_ptr、weak_ptr
 #include <sys/epoll.h>              // EPOLLIN、EPOLLPRI、EPOLLOUT
 
@@ -15,8 +17,8 @@ class EventLoop;
 class Channel : private noncopyable, private nonmoveable
 {
 public:
-    using EventCallback = std::function<void()>;
-    using ReadEventCallback = std::function<void(Timestamp)>;
+    using EventCallback = InplaceFunction<void()>;
+    using ReadEventCallback = InplaceFunction<void(Timestamp)>;
 
     Channel(EventLoop* loop, int fd);
     ~Channel() = default;
@@ -30,12 +32,16 @@ public:
     void setErrorCallback(EventCallback cb) { errorCallback_ = std::move(cb); }
 
     void tie(const std::shared_ptr<void>&);
+    // 被tie的对象还活着时返回它，否则为空：转到loop线程执行的update/remove持有它，执行前链接不会析构
+    std::shared_ptr<void> tieGuard() const { return tied_ ? tie_.lock() : nullptr; }
     // 返回我们需要监听的文件描述符
     int fd() const { return fd_; }
     // 返回我们设置的需要监听的事件
     int events() const { return events_; }
     // 保存发生的事件
     void set_revents(int revents) { revents_ = revents; }
+    // 返回发生的事件
+    int revents() const { return revents_; }
 
     // 设置fd相应的事件状态：监听读、写，不监听读、写、不监听任何事件
     // 这些函数确实经常被调用，虽然update的调用无法被内联优化，但是本身的函数调可以内联，从2次函数调用变成1次
@@ -50,11 +56,19 @@ public:
     bool isWriting() const { return events_ & kWriteEvent; }
     bool isReading() const { return events_ & kReadEvent; }
 
+    // 边沿触发：只在下一次update时生效，由支持边沿触发的poller（EPollPoller）加上EPOLLET，其他poller忽略
+    void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+    bool isEdgeTriggered() const { return edgeTriggered_; }
+
     int index() { return index_; }
     void set_index(int idx) { index_ = idx; }
 
     EventLoop* owerLoop() { return loop_; }
 
+    // 名字只用于诊断：卡顿检测报告慢回调属于哪个链接
+    void setName(const std::string& name) { name_ = name; }
+    const std::string& name() const { return name_; }
+
     // 将channel从事件循环中移除不在监听
     void remove();
 
@@ -96,6 +110,9 @@ private:
     int revents_;
     // channle的状态：是否在epoll树上
     int index_;
+    // 是否以边沿触发注册
+    bool edgeTriggered_;
+    std::string name_;
 
     // 防止在链接已经被关闭的情况下还去操作链接
     std::weak_ptr<void> tie_;
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>              // size_t
+
+
+class Channel;
+
+/*
+按fd下标直接索引的Channel表，代替unordered_map<int, Channel*>：
+1. 内核总是分配最小的可用fd，fd是从0开始的稠密小整数，直接作为数组下标
+2. 查找只有一次边界判断和一次数组读取，不需要计算哈希、遍历桶链表
+3. 插入、删除不分配节点，连接频繁建立断开时没有内存分配；数组只在出现更大的fd时按倍数扩容
+不持有channel对象，只在所属EventLoop的线程中使用
+*/
+class ChannelTable
+{
+public:
+    ChannelTable() : size_(0) {}
+
+    // fd未注册返回nullptr
+    Channel* find(int fd) const
+    {
+        return (fd >= 0 && static_cast<size_t>(fd) < slots_.size()) ? slots_[fd] : nullptr;
+    }
+
+    void insert(int fd, Channel* channel)
+    {
+        if (static_cast<size_t>(fd) >= slots_.size())
+        {
+            // 至少扩到两倍，fd逐个递增时不会每次都扩容
+            size_t n = slots_.size() * 2;
+            slots_.resize(n > static_cast<size_t>(fd) ? n : static_cast<size_t>(fd) + 1, nullptr);
+        }
+        if (slots_[fd] == nullptr)
+        {
+            ++size_;
+        }
+        slots_[fd] = channel;
+    }
+
+    void erase(int fd)
+    {
+        if (find(fd) != nullptr)
+        {
+            slots_[fd] = nullptr;
+            --size_;
+        }
+    }
+
+    // 已注册的channel数量
+    size_t size() const { return size_; }
+
+private:
+    std::vector<Channel*> slots_;
+    size_t size_;
+};
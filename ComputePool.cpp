@@ -0,0 +1,129 @@
+#include "ComputePool.h"
+#include "Thread.h"
+
+#include <cstdio>               // snprintf
+
+
+// 当前线程所属的计算线程池和在池中的下标，用来识别工作线程自己提交的任务
+static thread_local ComputePool* t_pool = nullptr;
+static thread_local int t_workerIndex = -1;
+
+ComputePool::ComputePool(int numThreads, const std::string& name)
+    : next_(0)
+    , queued_(0)
+    , sleeping_(0)
+    , quit_(false)
+    , executed_(0)
+    , stolen_(0)
+{
+    if (numThreads <= 0)
+    {
+        numThreads = 1;
+    }
+    for (int i = 0; i < numThreads; ++i)
+    {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    // 所有队列创建完再启动线程：线程一开始就可能去偷其他队列
+    for (int i = 0; i < numThreads; ++i)
+    {
+        char buf[name.size() + 32];
+        snprintf(buf, sizeof(buf), "%s%d", name.c_str(), i);
+        threads_.push_back(std::make_unique<Thread>(std::bind(&ComputePool::threadFunc, this, i), std::string(buf)));
+        threads_.back()->start();
+    }
+}
+
+ComputePool::~ComputePool()
+{
+    {
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        quit_ = true;
+    }
+    sleepCond_.notify_all();
+    for (auto& thread : threads_)
+    {
+        thread->join();
+    }
+}
+
+void ComputePool::submit(Task task)
+{
+    int index = (t_pool == this) ? t_workerIndex : static_cast<int>(next_.fetch_add(1, std::memory_order_relaxed) % workers_.size());
+    {
+        Worker& worker = *workers_[index];
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+    // 和睡眠前的检查配对：要么提交者看到有线程在睡眠并通知，要么睡眠的线程看到任务数大于0
+    queued_.fetch_add(1, std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_seq_cst) > 0)
+    {
+        {
+            std::unique_lock<std::mutex> lock(sleepMutex_);
+        }
+        sleepCond_.notify_one();
+    }
+}
+
+bool ComputePool::popLocal(int index, Task& task)
+{
+    Worker& worker = *workers_[index];
+    std::unique_lock<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty())
+    {
+        return false;
+    }
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool ComputePool::steal(int index, Task& task)
+{
+    int n = static_cast<int>(workers_.size());
+    for (int i = 1; i < n; ++i)
+    {
+        Worker& victim = *workers_[(index + i) % n];
+        // 对方正在操作自己的队列就换下一个，不在锁上等待
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (lock.owns_lock() && !victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            stolen_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ComputePool::threadFunc(int index)
+{
+    t_pool = this;
+    t_workerIndex = index;
+
+    Task task;
+    while (true)
+    {
+        if (popLocal(index, task) || steal(index, task))
+        {
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            task();
+            // 及时析构，释放任务持有的资源（比如TcpConnectionPtr）
+            task = nullptr;
+            executed_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        sleeping_.fetch_add(1, std::memory_order_seq_cst);
+        // 偷任务时try_lock失败可能漏掉任务，queued_才是准确的
+        sleepCond_.wait(lock, [this]() { return queued_.load(std::memory_order_seq_cst) > 0 || quit_; });
+        sleeping_.fetch_sub(1, std::memory_order_relaxed);
+        if (quit_ && queued_.load(std::memory_order_relaxed) == 0)
+        {
+            break;
+        }
+    }
+}
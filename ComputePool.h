@@ -0,0 +1,91 @@
+#pragma once
+#include "noncopyable.h"
+#include "nonmoveable.h"
+#include "InplaceFunction.h"
+#include "EventLoop.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>               // unique_ptr
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <type_traits>          // invoke_result_t、is_void_v
+#include <utility>              // move、forward
+
+class Thread;
+
+
+/*
+计算线程池：把MessageCallback中CPU密集的工作从IO线程卸载出去，计算能力按核数扩展，和IO loop的数量无关
+1. 每个工作线程一个双端队列：自己从队尾取（后进先出，缓存更热），空闲时从其他线程的队头偷任务（先进先出，偷走的是较早、较大的任务）
+2. 工作线程中提交的子任务放进自己的队列，不和其他线程竞争；其他线程（IO线程）提交的任务轮询分散到各个队列
+3. 所有队列都空时在条件变量上睡眠，有线程在睡眠时提交任务才需要加锁通知
+4. 析构时执行完已提交的任务再退出
+常见用法：在loop中提交，计算结果通过queueInLoop回到原来的loop，在loop线程中发送
+    pool.submit(conn->getLoop(), [req]() { return compute(req); },
+                [conn](std::string resp) { conn->send(resp); });
+*/
+class ComputePool : private noncopyable, private nonmoveable
+{
+public:
+    using Task = InplaceFunction<void()>;
+
+    explicit ComputePool(int numThreads, const std::string& name = std::string("ComputePool"));
+    ~ComputePool();
+
+    // 线程安全
+    void submit(Task task);
+
+    // 在计算线程执行work，完成后把结果交给loop，在loop线程中执行done(result)（work没有返回值时执行done()）
+    template <typename Work, typename Done>
+    void submit(EventLoop* loop, Work&& work, Done&& done)
+    {
+        submit([loop, work = std::forward<Work>(work), done = std::forward<Done>(done)]() mutable {
+            using Result = std::invoke_result_t<Work&>;
+            if constexpr (std::is_void_v<Result>)
+            {
+                work();
+                loop->queueInLoop([done = std::move(done)]() mutable { done(); });
+            }
+            else
+            {
+                loop->queueInLoop([done = std::move(done), result = work()]() mutable { done(std::move(result)); });
+            }
+        });
+    }
+
+    int numThreads() const { return static_cast<int>(workers_.size()); }
+    // 已经执行的任务数、从其他线程队列中偷来的任务数
+    uint64_t executed() const { return executed_.load(std::memory_order_relaxed); }
+    uint64_t stolen() const { return stolen_.load(std::memory_order_relaxed); }
+
+private:
+    // 每个工作线程的队列单独占缓存行，偷任务时不干扰其他线程
+    struct alignas(64) Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void threadFunc(int index);
+    // 从自己的队尾取任务
+    bool popLocal(int index, Task& task);
+    // 从其他线程的队头偷任务
+    bool steal(int index, Task& task);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::unique_ptr<Thread>> threads_;
+    // 外部线程提交时轮询选择队列
+    std::atomic<unsigned> next_;
+    // 所有队列中的任务总数
+    std::atomic<int64_t> queued_;
+    std::atomic<int> sleeping_;
+    std::mutex sleepMutex_;
+    std::condition_variable sleepCond_;
+    bool quit_;
+
+    std::atomic<uint64_t> executed_;
+    std::atomic<uint64_t> stolen_;
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include "FramePool.h"
+#include "Logger.h"
+
+#if __cplusplus < 202002L
+#error "Coroutine.h需要C++20（-std=c++20）"
+#endif
+
+#include <coroutine>
+#include <cstddef>              // size_t
+
+
+/*
+在loop中运行的协程：调用后立即在当前线程开始执行，第一次co_await挂起时返回，之后由链接的读写事件或者定时器在loop线程中恢复
+    CoTask echoLine(TcpConnectionPtr conn)
+    {
+        while (auto line = co_await conn->readUntil("\r\n"))
+        {
+            conn->send(*line + "\r\n");
+            co_await conn->drain();
+        }
+    }
+    // 在connectionCallback中启动，参数按值传递，链接的shared_ptr保存在协程帧里
+    echoLine(conn);
+1. 不需要等待结果（fire-and-forget），执行结束时帧自动释放，调用方不持有句柄
+2. 帧从当前线程（即当前loop）的FramePool分配，反复创建同样的协程不走malloc
+3. 协程中不能抛出异常，未捕获的异常按致命错误处理
+*/
+class CoTask
+{
+public:
+    struct promise_type
+    {
+        CoTask get_return_object() noexcept { return CoTask(); }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept
+        {
+            LOG_FATAL("CoTask 协程中出现未捕获的异常\n");
+        }
+
+        static void* operator new(size_t size) { return FramePool::local().allocate(size); }
+        static void operator delete(void* ptr) noexcept { FramePool::local().deallocate(ptr); }
+    };
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include "noncopyable.h"
+#include "nonmoveable.h"
+
+#include <mutex>
+#include <condition_variable>
+
+
+// 倒计时门闩：count个事件都发生后wait才返回，用来一次等待多个线程完成初始化（C++20才有std::latch）
+class CountDownLatch : private noncopyable, private nonmoveable
+{
+public:
+    explicit CountDownLatch(int count)
+        : count_(count) {}
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this]() { return count_ <= 0; });
+    }
+
+    void countDown()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (--count_ <= 0)
+        {
+            cond_.notify_all();
+        }
+    }
+
+    int count() const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return count_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    int count_;
+};
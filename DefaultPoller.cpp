@@ -1,18 +1,26 @@
 #include "Poller.h"
 #include "EPollPoller.h"
+#include "PollPoller.h"
+#include "IoUringPoller.h"
 
 #include <memory>               // unique_ptr
 
 
 std::unique_ptr<Poller> Poller::newDefaultPoller(EventLoop* loop)
 {
+    // fd很少的loop使用poll：没有epoll在内核中为每个fd维护的数据结构
     if (getenv("MUDUO_USE_POLL"))
     {
-        return nullptr;
+        return std::make_unique<PollPoller>(loop);
+    }
+    // 通过环境变量选择io_uring：channel事件的修改随下一次等待一起批量提交，不再每次修改都调用epoll_ctl
+    else if (getenv("MUDUO_USE_IOURING"))
+    {
+        return std::make_unique<IoUringPoller>(loop);
     }
     else
     {
         // return new EPollPoller(loop);
         return std::make_unique<EPollPoller>(loop);
     }
-}
\ No newline at end of file
+}
@@ -4,6 +4,7 @@
 
 #include <unistd.h>             // close
 #include <cstring>              // memeset
+#include <algorithm>            // max、min
 
 
 // 自定义channel状态：
@@ -24,6 +25,10 @@ EPollPoller::EPollPoller(EventLoop* loop)
     : Poller(loop)
     , epollFd_(epoll_create1(EPOLL_CLOEXEC))
     , epollEvents_(kInitEventListSize)
+    , minEvents_(kInitEventListSize)
+    , maxEvents_(kMaxEventListSize)
+    , avgEvents_(0)
+    , pollsSinceGrow_(0)
 {
     if (epollFd_ < 0)
     {
@@ -36,6 +41,16 @@ EPollPoller::~EPollPoller()
     close(epollFd_);
 }
 
+uint32_t EPollPoller::kernelEvents(const Channel* channel)
+{
+    uint32_t events = channel->events();
+    if (channel->isEdgeTriggered())
+    {
+        events |= EPOLLET;
+    }
+    return events;
+}
+
 void EPollPoller::update(int operation, Channel* channel)
 {
     epoll_event event;
@@ -43,7 +58,7 @@ void EPollPoller::update(int operation, Channel* channel)
 
     int fd = channel->fd();
 
-    event.events = channel->events();
+    event.events = kernelEvents(channel);
     event.data.fd = fd;
 
     // 关键操作：事件的数据指针指向channel指针
@@ -62,6 +77,65 @@ void EPollPoller::update(int operation, Channel* channel)
             LOG_FATAL("添加epoll树事件/修改epoll树事件失败：%d\n", errno);
         }
     }
+
+    // 记录内核中的实际状态，合并变化时和它比较
+    FdState& state = fdStates_[fd];
+    state.registered = operation != EPOLL_CTL_DEL;
+    state.events = state.registered ? event.events : 0;
+}
+
+void EPollPoller::markChanged(int fd)
+{
+    if (static_cast<size_t>(fd) >= fdStates_.size())
+    {
+        fdStates_.resize(std::max(fdStates_.size() * 2, static_cast<size_t>(fd) + 1));
+    }
+    FdState& state = fdStates_[fd];
+    if (!state.changed)
+    {
+        state.changed = true;
+        changedFds_.push_back(fd);
+    }
+}
+
+/*
+一个fd在一轮循环中无论变化多少次，只和内核中的状态比较一次：
+1. 请求/响应中先enableWriting再disableWriting，最终和内核一致，不需要任何epoll_ctl
+2. 新连接在同一轮中多次修改事件，只需要一次EPOLL_CTL_ADD
+*/
+void EPollPoller::flushChanges()
+{
+    for (int fd : changedFds_)
+    {
+        applyChange(fd);
+    }
+    changedFds_.clear();
+}
+
+void EPollPoller::applyChange(int fd)
+{
+    FdState& state = fdStates_[fd];
+    // removeChannel已经处理过，或者fd重复出现在列表中
+    if (!state.changed)
+    {
+        return;
+    }
+    state.changed = false;
+
+    Channel* channel = channels_.find(fd);
+    bool wanted = channel != nullptr && channel->index() == kAdded;
+    if (wanted && !state.registered)
+    {
+        update(EPOLL_CTL_ADD, channel);
+    }
+    else if (wanted && kernelEvents(channel) != state.events)
+    {
+        update(EPOLL_CTL_MOD, channel);
+    }
+    else if (!wanted && state.registered && channel != nullptr)
+    {
+        update(EPOLL_CTL_DEL, channel);
+    }
 }
 
 void EPollPoller::updateChannel(Channel* channel)
@@ -78,13 +152,10 @@ void EPollPoller::updateChannel(Channel* channel)
         {
             int fd = channel->fd();
             // 添加到poller的map上
-            channels_[fd] = channel;
+            channels_.insert(fd, channel);
         }
         // 不是一个全新的channle，已经从epoll树上删除，但还存在poller的map上，重新上epoll树
         channel->set_index(kAdded);
-
-        // 添加到epoll树上
-        update(EPOLL_CTL_ADD, channel);
     }
     else
     // channel在epoll树上，对epoll树上的channel进行操作
@@ -92,16 +163,14 @@ void EPollPoller::updateChannel(Channel* channel)
         // channel不监听任何事件，将channel从epoll树上删除
         if (channel->isNoneEvent())
         {
-            update(EPOLL_CTL_DEL, channel);
             channel->set_index(kDeleted);
-        }
-        else
-        {
-            // channel的更新操作
-            update(EPOLL_CTL_MOD, channel);
+            // disableAll之后fd可能不经过remove就被关闭：和removeChannel一样立即删除，不留下推迟到关闭之后的EPOLL_CTL_DEL
+            removeFromKernel(channel);
+            return;
         }
     }
-    
+    // 对epoll树的操作推迟到下一次epoll_wait之前合并提交
+    markChanged(channel->fd());
 }
 
 void EPollPoller::removeChannel(Channel* channel)
@@ -111,14 +180,68 @@ void EPollPoller::removeChannel(Channel* channel)
     channels_.erase(fd);
     // 日志打印
     LOG_INFO("func=%s, fd=%d\n", __func__, fd);
-    // 将channel从epoll树上删除
-    int index = channel->index();
-    if (index == kAdded)
+    // 移除后fd马上会被关闭并可能被新连接复用，不能推迟
+    removeFromKernel(channel);
+    channel->set_index(kNew);
+
+}
+
+void EPollPoller::removeFromKernel(Channel* channel)
+{
+    int fd = channel->fd();
+    if (static_cast<size_t>(fd) < fdStates_.size())
     {
-        update(EPOLL_CTL_DEL, channel);
+        FdState& state = fdStates_[fd];
+        // 内核中还有这个fd时立即从epoll树上删除
+        if (state.registered)
+        {
+            update(EPOLL_CTL_DEL, channel);
+        }
+        // 还没提交的变化直接丢弃：同一轮中ADD之后又DEL的fd不会到达内核
+        state.changed = false;
     }
-    channel->set_index(kNew);
+}
 
+void EPollPoller::setEventBatchSize(int initial, int max)
+{
+    minEvents_ = static_cast<size_t>(initial > 0 ? initial : 1);
+    maxEvents_ = std::max(minEvents_, static_cast<size_t>(max > 0 ? max : 1));
+    avgEvents_ = 0;
+    pollsSinceGrow_ = 0;
+    EventList(minEvents_).swap(epollEvents_);
+}
+
+/*
+1. 返回的事件填满了数组：还有就绪的fd没取到，翻倍（不超过上限），链接很多时用更少的epoll_wait取完就绪事件；
+   滑动平均至少提到这次的事件数，之前积累的小平均值不会让刚扩大的数组马上收缩
+2. 最近阻塞poll返回事件数的滑动平均（权重1/8）不到数组的1/4：减半（不低于初始大小），重新分配释放内存，
+   安静的loop不会一直占着一次突发留下的大数组；1/4和翻倍之间留有余量，不会在两个大小之间来回切换
+3. 0超时的poll（忙轮询自旋、后台任务积压）大多返回0个事件，只说明没有在等，不代表负载：只参与扩大，不参与平均和收缩
+4. 扩大之后至少经过kShrinkHoldPolls次阻塞poll才允许收缩，周期性的突发不会每次都重新分配
+*/
+void EPollPoller::adjustEventList(int numEvents, bool blocking)
+{
+    size_t size = epollEvents_.size();
+    if (static_cast<size_t>(numEvents) == size && size < maxEvents_)
+    {
+        epollEvents_.resize(std::min(size * 2, maxEvents_));
+        avgEvents_ = std::max(avgEvents_, static_cast<double>(numEvents));
+        pollsSinceGrow_ = 0;
+        return;
+    }
+    if (!blocking)
+    {
+        return;
+    }
+    avgEvents_ += (numEvents - avgEvents_) / 8;
+    if (pollsSinceGrow_ < kShrinkHoldPolls)
+    {
+        ++pollsSinceGrow_;
+    }
+    else if (size > minEvents_ && avgEvents_ * 4 < size)
+    {
+        EventList(std::max(size / 2, minEvents_)).swap(epollEvents_);
+    }
 }
 
 void EPollPoller::fillActiveChannels(int numEvents, ChannelList* activeChannels) const
@@ -126,8 +249,8 @@ void EPollPoller::fillActiveChannels(int numEvents, ChannelList* activeChannels)
     for (int i = 0; i < numEvents; i++)
     {
         Channel* channel = static_cast<Channel*>(epollEvents_[i].data.ptr);
-        // 保存channel返回的事件类型
-        channel->set_revents(channel->events());
+        // 保存channel返回的事件类型：必须是内核返回的事件，边沿触发时EPOLLOUT一直在监听，不能用监听的事件代替
+        channel->set_revents(epollEvents_[i].events);
         activeChannels->push_back(channel);
     }
     
@@ -136,8 +259,15 @@ void EPollPoller::fillActiveChannels(int numEvents, ChannelList* activeChannels)
 
 Timestamp EPollPoller::poll(int timeoutMs, ChannelList* activeChannels)
 {
-    // __func__：C++11标准的函数名
-    LOG_INFO("func=%s => fd total count:%lu \n", __func__, channels_.size());
+    // 忙轮询时0超时的poll非常频繁，不打印日志
+    if (timeoutMs != 0)
+    {
+        // __func__：C++11标准的函数名
+        LOG_INFO("func=%s => fd total count:%lu \n", __func__, channels_.size());
+    }
+
+    // 上一轮积累的channel变化在阻塞之前一次性提交
+    flushChanges();
 
     int numEvents = epoll_wait(epollFd_, &*epollEvents_.begin(), static_cast<int>(epollEvents_.size()), timeoutMs);
     int saveError = errno;
@@ -148,15 +278,14 @@ Timestamp EPollPoller::poll(int timeoutMs, ChannelList* activeChannels)
     {
         LOG_INFO("%d events happend \n", numEvents);
         fillActiveChannels(numEvents, activeChannels);
-        if (numEvents == epollEvents_.size())
-        {
-            epollEvents_.resize(numEvents * 2);
-        }
     }
     // 在timeoutMs秒内，没有监听的事件响应
     else if (numEvents == 0)
     {
-        LOG_DEBUG("%s timeout \n", __func__);
+        if (timeoutMs != 0)
+        {
+            LOG_DEBUG("%s timeout \n", __func__);
+        }
     }
     // epoll_wait阻塞打断
     else
@@ -167,6 +296,10 @@ Timestamp EPollPoller::poll(int timeoutMs, ChannelList* activeChannels)
             LOG_ERROR("EPollPoller::poll() error，errno=%d\n", saveError);
         }
     }
+    if (numEvents >= 0)
+    {
+        adjustEventList(numEvents, timeoutMs != 0);
+    }
 
     return now;
 }
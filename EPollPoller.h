@@ -3,6 +3,7 @@
 
 #include <sys/epoll.h>
 #include <vector>
+#include <cstdint>              // uint32_t
 
 
 class EPollPoller : public Poller
@@ -16,17 +17,57 @@ public:
     void updateChannel(Channel* channel) override;
     // 将channle从poller的map上删除、将channel从epoll树上删除
     void removeChannel(Channel* channel) override;
+    bool supportsEdgeTriggered() const override { return true; }
+    void setEventBatchSize(int initial, int max) override;
+    int eventBatchSize() const override { return static_cast<int>(epollEvents_.size()); }
 private:
+    // 内核中epoll树上一个fd的实际状态
+    struct FdState
+    {
+        FdState() : events(0), registered(false), changed(false) {}
+
+        uint32_t events;
+        bool registered;
+        // 已经记录在changedFds_中，等待提交
+        bool changed;
+    };
+
     // 填写活跃的链接
     void fillActiveChannels(int numEvents, ChannelList* activeChannels) const;
     // 更新channel：channel上epoll树操作、修改epoll树事件（channle）操作的封装
     void update(int operation, Channel* channel);
-    // 初始Epoll大小是16
+    // 根据这次返回的事件数调整事件数组大小；blocking为false表示0超时的poll
+    void adjustEventList(int numEvents, bool blocking);
+    // 记录fd的监听事件发生了变化，推迟到下一次epoll_wait之前提交
+    void markChanged(int fd);
+    // 把这一轮积累的变化合并后提交给内核
+    void flushChanges();
+    // 把一个fd的变化提交给内核
+    void applyChange(int fd);
+    // 立即把channel从epoll树上删除，丢弃还没提交的变化
+    void removeFromKernel(Channel* channel);
+    // channel期望在内核中监听的事件
+    static uint32_t kernelEvents(const Channel* channel);
+    // 事件数组默认初始16个，最多扩到4096个
     static constexpr int kInitEventListSize = 16;
+    static constexpr int kMaxEventListSize = 4096;
+    // 扩大之后至少经过这么多次阻塞poll才允许收缩
+    static constexpr int kShrinkHoldPolls = 32;
     // epoll树根节点
     int epollFd_;
 
     using EventList = std::vector<epoll_event>;
     // epoll事件集合
     EventList epollEvents_;
+    // 事件数组大小的下限（初始大小）和上限
+    size_t minEvents_;
+    size_t maxEvents_;
+    // 每次阻塞的epoll_wait返回事件数的滑动平均
+    double avgEvents_;
+    // 上一次扩大之后阻塞poll的次数，到kShrinkHoldPolls为止
+    int pollsSinceGrow_;
+    // 按fd索引的内核状态
+    std::vector<FdState> fdStates_;
+    // 这一轮中监听事件发生变化的fd
+    std::vector<int> changedFds_;
 };
\ No newline at end of file
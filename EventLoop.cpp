@@ -2,14 +2,29 @@
 #include "EventLoop.h"
 #include "Poller.h"
 #include "Channel.h"
+#include "TimerQueue.h"
+#include "TimingWheel.h"
+#include "BufferPool.h"
+#include "IoUringPoller.h"
 
 #include <sys/eventfd.h>
+#include <algorithm>              // min
 
 const int kPollTimeMs = 10000;
+// 每轮执行后台任务的默认预算
+const int kBackgroundMaxTasks = 64;
+const int kBackgroundMaxUs = 1000;
 
 // 防止一个线程创建多个EventLoop
 thread_local EventLoop* t_loopInThisThread = nullptr;
 
+// 两个时间点之间的微秒数，系统时间被回拨时记为0
+static int64_t elapsedUs(Timestamp from, Timestamp to)
+{
+    int64_t us = to.microSecondsSinceEpoch() - from.microSecondsSinceEpoch();
+    return us > 0 ? us : 0;
+}
+
 
 int createEventfd()
 {
@@ -32,6 +47,10 @@ void EventLoop::handleRead()
     {
         LOG_ERROR("EventLoop::handleRead() reads %lu bytes instead of 8", n);
     }
+    // 必须在doPendingFunctors取任务之前清除：之后投递的任务会重新写eventfd，之前投递的任务这一轮一定能取到
+    // 使用exchange而不是store：和跳过写eventfd的生产者的exchange同步，保证看到它push的任务
+    wakeupPending_.exchange(false, std::memory_order_acq_rel);
+    stats_.recordWakeup();
 }
 
 EventLoop::EventLoop()
@@ -39,9 +58,31 @@ EventLoop::EventLoop()
     , quit_(false)
     , threadId_(CurrentThread::tid())
     , poller_(Poller::newDefaultPoller(this))
+    , ioUringPoller_(dynamic_cast<IoUringPoller*>(poller_.get()))
+    , timerQueue_(std::make_unique<TimerQueue>(this))
+    , timingWheel_(std::make_unique<TimingWheel>(this))
+    , bufferPool_(std::make_shared<BufferPool>(this))
     , wakeupFd_(createEventfd())
     , wakeupChannel_(std::make_unique<Channel>(this, wakeupFd_))
+    , wakeupPending_(false)
+    , elidedWakeups_(0)
+    , busyPollMaxUs_(0)
+    , socketBusyPollUs_(0)
+    , spinBudgetUs_(0)
+    , avgEventGapUs_(0)
+    , spinPolls_(0)
+    , blockingPolls_(0)
+    , connectionCount_(0)
+    , bufferedBytes_(0)
+    , stallThresholdUs_(0)
+    , activityChannel_(nullptr)
+    , activitySeq_(0)
+    , activityStartUs_(0)
+    , activityFd_(-1)
+    , activityKind_(static_cast<int>(LoopActivity::kIdle))
     , callingPendingFunctors_(false)
+    , backgroundMaxTasks_(kBackgroundMaxTasks)
+    , backgroundMaxUs_(kBackgroundMaxUs)
 {
     LOG_INFO("事件循环：%p创建在线程：%d\n", this, threadId_);
     if (t_loopInThisThread)
@@ -61,6 +102,8 @@ EventLoop::EventLoop()
 
 EventLoop::~EventLoop()
 {
+    // loop已经不再运行，可以在其他线程中析构：析构所在的线程接管loop，下面各成员对poller的修改直接执行而不是投递到任务队列
+    threadId_ = CurrentThread::tid();
     /*
     为什么要先disableAll在remove？
     1. 某个channel的数据包到达网卡，TCP协议栈处理，设置socket为可读
@@ -72,6 +115,14 @@ EventLoop::~EventLoop()
     7. epoll_wait中返回了已经被删除的channel，对这个channel进行操作的行为是未定义的，可能导致崩溃
     */
 
+    // io_uring操作的回调持有TcpConnection：poller_最后析构，必须在时间轮、内存池等成员销毁之前释放这些链接
+    if (ioUringPoller_ != nullptr)
+    {
+        ioUringPoller_->cancelAllCompletions();
+    }
+    // 之后析构的链接（还在任务队列、定时器中，或者被用户代码持有）把存储直接还给系统
+    bufferPool_->detach();
+
     wakeupChannel_->disableAll();
     // 从poller的map上删除，如果还未从epoll树上删除就执行删除操作，并且将channle状态设置成kNew
     wakeupChannel_->remove();
@@ -82,51 +133,242 @@ EventLoop::~EventLoop()
 void EventLoop::loop()
 {
     looping_ = true;
-    quit_ = false;
 
     LOG_INFO("事件循环：%p开启循环\n", this);
 
     while(!quit_)
     {
         activeChannels_.clear();
-        pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
+        Timestamp pollStart(Timestamp::now());
+        pollReturnTime_ = busyPollMaxUs_ > 0 ? busyPoll() : poller_->poll(pollTimeoutMs(), &activeChannels_);
+        stats_.recordPoll(elapsedUs(pollStart, pollReturnTime_), activeChannels_.size());
         // 执行clientfd相关回调
         for (Channel* channel : activeChannels_)
         {
             channel->handleEvent(pollReturnTime_);
         }
+        Timestamp handled(Timestamp::now());
+        stats_.recordHandlers(elapsedUs(pollReturnTime_, handled));
 
         // 执行loop之间设置的回调操作
-        doPendingFunctors();
+        size_t functors = doPendingFunctors();
+        Timestamp done(Timestamp::now());
+        stats_.recordFunctors(functors, elapsedUs(handled, done));
+
+        // 从poll返回到处理完回调都是忙碌时间
+        stats_.recordBusy(elapsedUs(pollReturnTime_, done));
     }
 
     LOG_INFO("事件循环%p结束\n", this);
     looping_ = false;
+    // 在退出时而不是进入时复位：loop()开始前到达的quit()不会被覆盖掉
+    quit_ = false;
+
+}
+
+void EventLoop::setBusyPoll(int maxSpinUs, int socketBusyPollUs)
+{
+    busyPollMaxUs_ = maxSpinUs > 0 ? maxSpinUs : 0;
+    socketBusyPollUs_ = socketBusyPollUs > 0 ? socketBusyPollUs : 0;
+    // 一开始按上限自旋，之后由事件间隔调整
+    spinBudgetUs_.store(busyPollMaxUs_, std::memory_order_relaxed);
+    avgEventGapUs_ = 0;
+    lastEventTime_ = Timestamp::invalid();
+}
+
+Timestamp EventLoop::busyPoll()
+{
+    const int budgetUs = spinBudgetUs_.load(std::memory_order_relaxed);
+    Timestamp start(Timestamp::now());
+    Timestamp now(start);
+    // 预算为0时直接阻塞；跨线程投递的任务和定时器也是fd事件，自旋期间同样能收到
+    while (budgetUs > 0)
+    {
+        now = poller_->poll(0, &activeChannels_);
+        spinPolls_.store(spinPolls_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (!activeChannels_.empty() || quit_ || now.microSecondsSinceEpoch() - start.microSecondsSinceEpoch() >= budgetUs)
+        {
+            break;
+        }
+    }
+    if (activeChannels_.empty() && !quit_)
+    {
+        now = poller_->poll(pollTimeoutMs(), &activeChannels_);
+        blockingPolls_.store(blockingPolls_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    if (!activeChannels_.empty())
+    {
+        adaptSpinBudget(now);
+    }
+    return now;
+}
 
+void EventLoop::adaptSpinBudget(Timestamp now)
+{
+    if (lastEventTime_.valid())
+    {
+        int64_t gapUs = now.microSecondsSinceEpoch() - lastEventTime_.microSecondsSinceEpoch();
+        // 权重1/8的滑动平均：对突发敏感，又不会被单次的长间隔打乱
+        avgEventGapUs_ = avgEventGapUs_ == 0 ? gapUs : avgEventGapUs_ + (gapUs - avgEventGapUs_) / 8;
+        // 平均间隔在上限之内：自旋两倍的平均间隔基本可以等到下一个事件；否则自旋只是空转，直接阻塞
+        int budgetUs = 0;
+        if (avgEventGapUs_ <= busyPollMaxUs_)
+        {
+            budgetUs = static_cast<int>(std::min<int64_t>(avgEventGapUs_ * 2, busyPollMaxUs_));
+        }
+        spinBudgetUs_.store(budgetUs, std::memory_order_relaxed);
+    }
+    lastEventTime_ = now;
 }
 
-void EventLoop::doPendingFunctors()
+size_t EventLoop::doPendingFunctors()
 {
-    std::vector<Functor> functors;
     callingPendingFunctors_ = true;
 
-    // 执行回调的EventLoop通过临时变量直接交换任务队列中的任务，快速释放锁
+    // 先把队列中已有的任务全部取出再执行：执行过程中新投递的任务留到下一轮，不会饿死IO事件；紧急任务排在前面
+    Functor functor;
+    while (urgentFunctors_.pop(functor))
+    {
+        runningFunctors_.push_back(std::move(functor));
+    }
+    while (pendingFunctors_.pop(functor))
     {
-        std::unique_lock<std::mutex> lock(mutex_);
-        functors.swap(pendingFunctors_);
+        runningFunctors_.push_back(std::move(functor));
+    }
+    // 后台任务也在这时取出：执行期间新投递的后台任务不会排到新投递的紧急任务前面
+    while (backgroundFunctors_.pop(functor))
+    {
+        backgroundBacklog_.push_back(std::move(functor));
     }
 
     // 执行回调
-    for (const Functor& functor : functors)
+    for (const Functor& functor : runningFunctors_)
     {
+        beginActivity(nullptr, LoopActivity::kFunctor);
         functor();
+        endActivity();
     }
+    size_t count = runningFunctors_.size();
+    runningFunctors_.clear();
+
+    count += doBackgroundFunctors();
 
     callingPendingFunctors_ = false;
+    return count;
+}
+
+size_t EventLoop::doBackgroundFunctors()
+{
+    Functor functor;
+    size_t count = 0;
+    Timestamp start(Timestamp::now());
+    while (!backgroundBacklog_.empty())
+    {
+        // 先从积压中取出再执行：任务中可能继续投递后台任务
+        functor = std::move(backgroundBacklog_.front());
+        backgroundBacklog_.pop_front();
+        beginActivity(nullptr, LoopActivity::kFunctor);
+        functor();
+        endActivity();
+        ++count;
+        if (count >= static_cast<size_t>(backgroundMaxTasks_)
+            || Timestamp::now().microSecondsSinceEpoch() - start.microSecondsSinceEpoch() >= backgroundMaxUs_)
+        {
+            break;
+        }
+    }
+    return count;
+}
+
+int EventLoop::pollTimeoutMs() const
+{
+    return backgroundBacklog_.empty() ? kPollTimeMs : 0;
+}
+
+void EventLoop::setBackgroundBudget(int maxTasks, int maxUs)
+{
+    backgroundMaxTasks_ = maxTasks > 0 ? maxTasks : 1;
+    backgroundMaxUs_ = maxUs > 0 ? maxUs : 1;
+}
+
+void EventLoop::setStallDetection(int64_t thresholdUs, std::function<void(const LoopStall&)> cb)
+{
+    stallThresholdUs_ = thresholdUs > 0 ? thresholdUs : 0;
+    stallCallback_ = std::move(cb);
+}
+
+void EventLoop::recordActivityBegin(const Channel* channel, LoopActivity activity)
+{
+    activityChannel_ = channel;
+    // 顺序锁：写之前序号变成奇数，写完变成偶数，watchdog读到奇数或者前后序号不同就放弃这次读取
+    uint64_t seq = activitySeq_.load(std::memory_order_relaxed);
+    activitySeq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    activityFd_.store(channel ? channel->fd() : -1, std::memory_order_relaxed);
+    activityKind_.store(static_cast<int>(activity), std::memory_order_relaxed);
+    activityStartUs_.store(Timestamp::now().microSecondsSinceEpoch(), std::memory_order_relaxed);
+    activitySeq_.store(seq + 2, std::memory_order_release);
+}
+
+void EventLoop::recordActivityEnd()
+{
+    int64_t startUs = activityStartUs_.load(std::memory_order_relaxed);
+    // 回调执行期间才打开的检测（setStallDetection本身就在任务中执行），没有开始时间
+    if (startUs == 0)
+    {
+        return;
+    }
+    activityStartUs_.store(0, std::memory_order_relaxed);
+    int64_t elapsed = Timestamp::now().microSecondsSinceEpoch() - startUs;
+    if (elapsed >= stallThresholdUs_ && stallCallback_)
+    {
+        LoopStall stall;
+        stall.loop = this;
+        stall.tid = threadId_;
+        stall.fd = activityFd_.load(std::memory_order_relaxed);
+        stall.activity = static_cast<LoopActivity>(activityKind_.load(std::memory_order_relaxed));
+        stall.elapsedUs = elapsed;
+        stall.finished = true;
+        // 回调刚结束，channel还在：回调中不能析构自己的channel
+        if (activityChannel_)
+        {
+            stall.name = activityChannel_->name();
+        }
+        stallCallback_(stall);
+    }
+    activityChannel_ = nullptr;
+}
+
+int64_t EventLoop::currentActivity(LoopStall* stall, uint64_t* seq) const
+{
+    uint64_t before = activitySeq_.load(std::memory_order_acquire);
+    if (before & 1)
+    {
+        return 0;
+    }
+    int64_t startUs = activityStartUs_.load(std::memory_order_relaxed);
+    stall->loop = const_cast<EventLoop*>(this);
+    stall->tid = threadId_;
+    stall->fd = activityFd_.load(std::memory_order_relaxed);
+    stall->activity = static_cast<LoopActivity>(activityKind_.load(std::memory_order_relaxed));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // 读取期间进入了下一个回调，读到的内容可能不一致，这一次不报告，下次检查再读
+    if (activitySeq_.load(std::memory_order_relaxed) != before)
+    {
+        return 0;
+    }
+    *seq = before;
+    return startUs;
 }
 
 void EventLoop::wakeup()
 {
+    // 已经有一次唤醒在路上，loop醒来后会处理到这次投递的任务
+    if (wakeupPending_.exchange(true, std::memory_order_acq_rel))
+    {
+        elidedWakeups_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
     uint64_t one = 1;
     ssize_t n = write(wakeupFd_, &one, sizeof(one));
     if (n != sizeof(one))
@@ -147,12 +389,20 @@ void EventLoop::quit()
     }
 }
 
-void EventLoop::queueInLoop(Functor cb)
+void EventLoop::queueInLoop(Functor cb, Priority priority)
 {
-    // 将cb回调放入回调任务队列
+    // 将cb回调放入对应优先级的任务队列：无锁push
+    switch (priority)
     {
-        std::unique_lock<std::mutex> lock(mutex_);
-        pendingFunctors_.emplace_back(cb);
+    case kUrgent:
+        urgentFunctors_.push(std::move(cb));
+        break;
+    case kBackground:
+        backgroundFunctors_.push(std::move(cb));
+        break;
+    default:
+        pendingFunctors_.push(std::move(cb));
+        break;
     }
     // 唤醒条件1：eventLoop不在自己的线程， 唤醒条件2：eventloop正在执行回调，为了上面提交的回调任务被及时执行就让这个EventLoop执行完成后再去任务队列中去新添加的回调
     if (!isInLoopThread() || callingPendingFunctors_)
@@ -169,21 +419,70 @@ void EventLoop::runInLoop(Functor cb)
     }
     else
     {
-        queueInLoop(cb);
+        queueInLoop(std::move(cb));
     }
 }
 
+TimerId EventLoop::runAt(Timestamp time, TimerCallback cb)
+{
+    return timerQueue_->addTimer(std::move(cb), time, 0.0);
+}
+
+TimerId EventLoop::runAfter(double delay, TimerCallback cb)
+{
+    Timestamp time(addTime(Timestamp::now(), delay));
+    return runAt(time, std::move(cb));
+}
+
+TimerId EventLoop::runEvery(double interval, TimerCallback cb)
+{
+    Timestamp time(addTime(Timestamp::now(), interval));
+    return timerQueue_->addTimer(std::move(cb), time, interval);
+}
+
+void EventLoop::cancel(TimerId timerId)
+{
+    timerQueue_->cancel(timerId);
+}
+
 void EventLoop::removeChannel(Channel* channle)
 {
-    poller_->removeChannel(channle);
+    if (isInLoopThread())
+    {
+        poller_->removeChannel(channle);
+        return;
+    }
+    // poller的状态只在loop线程中修改；被tie的链接由任务持有，执行前不会析构
+    queueInLoop([this, channle, guard = channle->tieGuard()]() { poller_->removeChannel(channle); }, kUrgent);
 }
 
 void EventLoop::updateChannel(Channel* channle)
 {
-    poller_->updateChannel(channle);
+    if (isInLoopThread())
+    {
+        poller_->updateChannel(channle);
+        return;
+    }
+    // 执行时按channel当时的事件更新，多次修改只生效最后一次
+    queueInLoop([this, channle, guard = channle->tieGuard()]() { poller_->updateChannel(channle); }, kUrgent);
 }
 
 bool EventLoop::hasChannel(Channel* channle)
 {
     return poller_->hasChannel(channle);
+}
+
+void EventLoop::setPollBatchSize(int initial, int max)
+{
+    poller_->setEventBatchSize(initial, max);
+}
+
+int EventLoop::pollBatchSize() const
+{
+    return poller_->eventBatchSize();
+}
+
+bool EventLoop::supportsEdgeTriggered() const
+{
+    return poller_->supportsEdgeTriggered();
 }
\ No newline at end of file
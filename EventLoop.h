@@ -3,21 +3,45 @@
 #include "nonmoveable.h"
 #include "CurrentThread.h"
 #include "Timestamp.h"
+#include "Callbacks.h"
+#include "TimerId.h"
+#include "MpscQueue.h"
+#include "LoopStats.h"
+#include "LoopWatchdog.h"
 
-#include <memory>               // unique_ptr
+#include <memory>               // unique_ptr、shared_ptr
 #include <atomic>
-#include <mutex>
 #include <functional>
 #include <vector>
+#include <deque>
 
 class Channel;
 class Poller;
+class TimerQueue;
+class TimingWheel;
+class IoUringPoller;
+class BufferPool;
 
 
 class EventLoop : private noncopyable, private nonmoveable
 {
 public:
-    using Functor = std::function<void()>;
+    // 只能移动的小对象优化任务：投递任务时不再拷贝，也不为常见大小的bind分配堆内存
+    using Functor = InplaceFunction<void()>;
+
+    /*
+    queueInLoop的任务优先级：
+    kUrgent：本轮最先执行
+    kNormal：本轮执行，和原来的行为一样，本轮已经在队列中的任务全部执行完
+    kBackground：广播、清理等可以延后的任务，每轮只在预算内执行一部分，剩下的留到之后的轮次，
+                 不会因为积压大量后台任务推迟下一次poll，IO的延迟有上限
+    */
+    enum Priority
+    {
+        kUrgent,
+        kNormal,
+        kBackground,
+    };
 
     EventLoop();
     ~EventLoop();
@@ -30,41 +54,208 @@ public:
     // 在当前loop中执行cb
     void runInLoop(Functor cb);
     // 将cb放入队列，唤醒Loop所在的线程去执行cb
-    void queueInLoop(Functor cb);
+    void queueInLoop(Functor cb, Priority priority = kNormal);
+    // 每轮执行后台任务的预算：最多maxTasks个、最多maxUs微秒，至少执行一个保证进度；必须在loop开始之前或者在loop线程中调用
+    void setBackgroundBudget(int maxTasks, int maxUs);
+    // 积压在loop中还没执行的后台任务数，只能在loop线程调用
+    size_t backgroundBacklog() const { return backgroundBacklog_.size(); }
+
+    /*
+    自适应忙轮询：每次阻塞等待之前先用0超时poll最多maxSpinUs微秒，用一个核换取更低的尾延迟，<=0关闭
+    实际自旋的预算随最近事件到达的间隔调整：间隔比maxSpinUs长时自旋只是空转，预算降为0直接阻塞
+    socketBusyPollUs>0时这个loop上建立的链接设置SO_BUSY_POLL（超过net.core.busy_read需要CAP_NET_ADMIN）
+    必须在loop开始之前或者在loop线程中调用
+    */
+    void setBusyPoll(int maxSpinUs, int socketBusyPollUs = 0);
+    int socketBusyPollUs() const { return socketBusyPollUs_; }
+    // 忙轮询的统计：0超时poll的次数、阻塞poll的次数、当前的自旋预算（微秒）
+    uint64_t spinPolls() const { return spinPolls_.load(std::memory_order_relaxed); }
+    uint64_t blockingPolls() const { return blockingPolls_.load(std::memory_order_relaxed); }
+    int spinBudgetUs() const { return spinBudgetUs_.load(std::memory_order_relaxed); }
+
+    // 单次poll最多取回的事件数：从initial开始，在[initial, max]内随返回的事件数自动伸缩，只对epoll后端生效
+    // 链接很多的loop调大max可以减少epoll_wait的次数；必须在loop开始之前或者在loop线程中调用
+    void setPollBatchSize(int initial, int max);
+    int pollBatchSize() const;
 
-    // 唤醒Loop所在的线程
+    // 负载统计：链接数、缓冲区字节数由TcpConnection维护，忙碌时间由loop维护，EventLoopThreadPool在其他线程读取用来分配新链接
+    int connectionCount() const { return connectionCount_.load(std::memory_order_relaxed); }
+    int64_t bufferedBytes() const { return bufferedBytes_.load(std::memory_order_relaxed); }
+    // 处理事件与回调累计花费的时间，单位微秒，单调递增
+    int64_t totalBusyUs() const { return stats_.busyUs(); }
+    void addConnectionCount(int delta) { connectionCount_.fetch_add(delta, std::memory_order_relaxed); }
+    void addBufferedBytes(int64_t delta) { bufferedBytes_.fetch_add(delta, std::memory_order_relaxed); }
+
+    // 唤醒Loop所在的线程：已经有一次唤醒还没被loop处理时不再重复写eventfd
     void wakeup();
+    // 被合并掉（没有真正写eventfd）的唤醒次数
+    uint64_t elidedWakeups() const { return elidedWakeups_.load(std::memory_order_relaxed); }
+
+    // 运行统计的快照：poll批量大小、阻塞与忙碌时间、事件处理耗时、任务队列深度、唤醒次数，可以在任意线程调用
+    LoopStatsSnapshot stats() const { return stats_.snapshot(); }
 
+    /*
+    卡顿检测，一般由LoopWatchdog打开：
+    单个回调执行超过thresholdUs微秒时，回调结束后在loop线程中调用cb报告（带上channel名字），thresholdUs<=0关闭
+    只能在loop线程中调用
+    */
+    void setStallDetection(int64_t thresholdUs, std::function<void(const LoopStall&)> cb);
+    // Channel和doPendingFunctors在每个回调前后调用，更新给watchdog看的心跳
+    void beginActivity(const Channel* channel, LoopActivity activity)
+    {
+        if (stallThresholdUs_ > 0)
+        {
+            recordActivityBegin(channel, activity);
+        }
+    }
+    void endActivity()
+    {
+        if (stallThresholdUs_ > 0)
+        {
+            recordActivityEnd();
+        }
+    }
+    /*
+    线程安全：读取当前正在执行的回调，填写stall的loop、tid、fd、activity，seq为这次回调的序号
+    返回回调开始的时间（微秒），loop空闲或者读取期间回调发生了切换返回0
+    */
+    int64_t currentActivity(LoopStall* stall, uint64_t* seq) const;
+
+    // 定时器接口，线程安全：可以在其他线程调用
+    // 在time时间点执行cb
+    TimerId runAt(Timestamp time, TimerCallback cb);
+    // 在delay秒后执行cb
+    TimerId runAfter(double delay, TimerCallback cb);
+    // 每隔interval秒执行一次cb
+    TimerId runEvery(double interval, TimerCallback cb);
+    // 取消定时器
+    void cancel(TimerId timerId);
+    class SleepAwaiter;
+    // 协程中co_await loop->sleepFor(seconds)：由定时器在loop线程中直接恢复，只能在这个loop的协程中使用（C++20，见Coroutine.h）
+    SleepAwaiter sleepFor(double seconds);
+    // 连接空闲超时使用的时间轮，只能在loop线程中使用
+    TimingWheel* timingWheel() const { return timingWheel_.get(); }
+    // 这个loop上链接的缓冲区使用的内存池，只能在loop线程中使用
+    BufferPool* bufferPool() const { return bufferPool_.get(); }
+    // 链接持有一份引用：链接可能在loop析构之后才析构
+    std::shared_ptr<BufferPool> sharedBufferPool() const { return bufferPool_; }
+    // 使用io_uring后端时返回对应的poller，用于完成模式的收发，其他后端返回空
+    IoUringPoller* ioUringPoller() const { return ioUringPoller_; }
+
+    // poller的状态只在loop线程访问：在其他线程调用时投递到loop线程执行，不阻塞调用方；
+    // 没有tie的channel要活到loop执行完这个任务
     void removeChannel(Channel* channel);
     void updateChannel(Channel* channel);
     bool hasChannel(Channel* channel);
+    // 当前poller是否支持边沿触发
+    bool supportsEdgeTriggered() const;
 
     // 判断EventLoop对象是否在自己的线程里面（一个线程一个EventLoop），但是主Loop能够持有IOLoop对象
     bool isInLoopThread() const { return threadId_ == CurrentThread::tid(); }
+    // loop()正在运行：还没开始或者已经返回时，投递的任务不会被执行
+    bool looping() const { return looping_; }
 private:
     void handleRead();
-    void doPendingFunctors();
+    // 返回执行的任务数
+    size_t doPendingFunctors();
+    // 在预算内执行后台任务，返回执行的任务数
+    size_t doBackgroundFunctors();
+    // 还有积压的后台任务时poll不阻塞
+    int pollTimeoutMs() const;
+    void recordActivityBegin(const Channel* channel, LoopActivity activity);
+    void recordActivityEnd();
+    // 忙轮询模式下的一次等待：先自旋再阻塞
+    Timestamp busyPoll();
+    // 根据这次事件和上次事件的间隔调整自旋预算
+    void adaptSpinBudget(Timestamp now);
 
     using ChannelList = std::vector<Channel*>;
 
     std::atomic_bool looping_;
     std::atomic_bool quit_;
 
-    const pid_t threadId_;
+    // 析构时改成析构所在的线程
+    pid_t threadId_;
 
     // poller返回监听事件的时间点
     Timestamp pollReturnTime_;
     std::unique_ptr<Poller> poller_;
+    IoUringPoller* ioUringPoller_;
+    // 定时器队列：依赖poller_注册timerfd，所以必须在poller_之后构造
+    std::unique_ptr<TimerQueue> timerQueue_;
+    // 时间轮的tick定时器依赖timerQueue_
+    std::unique_ptr<TimingWheel> timingWheel_;
+    // 回收定时器依赖timerQueue_
+    std::shared_ptr<BufferPool> bufferPool_;
 
     int wakeupFd_;
     std::unique_ptr<Channel> wakeupChannel_;
+    // 已经写过eventfd但loop还没有读：一轮循环内的多次唤醒只写一次eventfd
+    std::atomic_bool wakeupPending_;
+    std::atomic<uint64_t> elidedWakeups_;
 
     ChannelList activeChannels_;
 
+    // 忙轮询：自旋预算的上限，<=0表示不忙轮询
+    int busyPollMaxUs_;
+    int socketBusyPollUs_;
+    // 自适应的自旋预算，其他线程只读
+    std::atomic<int> spinBudgetUs_;
+    // 事件到达间隔的滑动平均，单位微秒
+    int64_t avgEventGapUs_;
+    Timestamp lastEventTime_;
+    // 只有loop线程写，其他线程读取统计
+    std::atomic<uint64_t> spinPolls_;
+    std::atomic<uint64_t> blockingPolls_;
+
+    // 负载统计
+    std::atomic<int> connectionCount_;
+    std::atomic<int64_t> bufferedBytes_;
+
+    // 运行统计，只有loop线程写
+    LoopStats stats_;
+
+    // 卡顿检测：阈值和报告回调只在loop线程访问
+    int64_t stallThresholdUs_;
+    std::function<void(const LoopStall&)> stallCallback_;
+    const Channel* activityChannel_;
+    // 心跳：loop线程写，watchdog线程读；activityStartUs_为0表示没有回调在执行
+    std::atomic<uint64_t> activitySeq_;
+    std::atomic<int64_t> activityStartUs_;
+    std::atomic<int> activityFd_;
+    std::atomic<int> activityKind_;
+
     // 标识当前loop是否有需要执行的回调操作
     std::atomic_bool callingPendingFunctors_;
-    // 存储当前loop需要执行的回调操作
-    std::vector<Functor> pendingFunctors_;
-    // 保护pendingFunctors_的线程安全
-    std::mutex mutex_;
-};
\ No newline at end of file
+    // 存储当前loop需要执行的回调操作：无锁队列，其他线程投递任务不需要加锁，每种优先级一个队列
+    MpscQueue<Functor> urgentFunctors_;
+    MpscQueue<Functor> pendingFunctors_;
+    MpscQueue<Functor> backgroundFunctors_;
+    // 本轮要执行的回调，复用内存
+    std::vector<Functor> runningFunctors_;
+    // 已经从队列中取出、还没执行的后台任务，只在loop线程访问
+    std::deque<Functor> backgroundBacklog_;
+    int backgroundMaxTasks_;
+    int backgroundMaxUs_;
+};
+
+// await_suspend写成模板，这个头文件不需要C++20也能编译
+class EventLoop::SleepAwaiter
+{
+public:
+    SleepAwaiter(EventLoop* loop, double seconds) : loop_(loop), seconds_(seconds) {}
+
+    bool await_ready() const { return seconds_ <= 0; }
+    template <typename Handle>
+    void await_suspend(Handle handle)
+    {
+        loop_->runAfter(seconds_, [handle]() { handle.resume(); });
+    }
+    void await_resume() const {}
+
+private:
+    EventLoop* loop_;
+    double seconds_;
+};
+
+inline EventLoop::SleepAwaiter EventLoop::sleepFor(double seconds) { return SleepAwaiter(this, seconds); }
@@ -1,22 +1,38 @@
 #include "EventLoopThread.h"
 #include "EventLoop.h"
+#include "Logger.h"
+#include "CountDownLatch.h"
+
+#include <pthread.h>                // pthread_setaffinity_np
+#include <sched.h>                  // cpu_set_t
+#include <sys/syscall.h>            // SYS_set_mempolicy
+#include <linux/mempolicy.h>        // MPOL_LOCAL
 
 
 EventLoopThread::EventLoopThread(const ThreadInitCallback& cb, const std::string& name)
     : loop_(nullptr)
     , exiting_(false)
     , thread_(std::bind(&EventLoopThread::threadFunc, this), name)
-    , callback_(cb) {}
+    , callback_(cb)
+    , cpu_(-1)
+    , latch_(nullptr) {}
 
 
 EventLoopThread::~EventLoopThread()
 {
     exiting_ = true;
-    if (loop_ != nullptr)
     {
-        // 让子线程退出循环
-        loop_->quit();
-        // 等待子线程退出循环
+        // loop可能已经自己退出了（例如EventLoopThreadPool::stop投递的quit），子线程清空loop_之后loop就析构了，必须加锁访问
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (loop_ != nullptr)
+        {
+            // 让子线程退出循环
+            loop_->quit();
+        }
+    }
+    // 等待子线程退出：loop先退出时子线程也可能还在访问这个对象
+    if (thread_.started())
+    {
         thread_.join();
     }
 }
@@ -26,7 +42,6 @@ EventLoop* EventLoopThread::startLoop()
     // 启动子线程，子线程运行EventLoopThread::threadFunc()
     thread_.start();
     EventLoop* loop = nullptr;
-    sleep(1);
     {
         std::unique_lock<std::mutex> lock(mutex_);
         // 等待子线程赋值后通知
@@ -41,8 +56,44 @@ EventLoop* EventLoopThread::startLoop()
 }
 
 
+void EventLoopThread::startLoopAsync(CountDownLatch* latch)
+{
+    latch_ = latch;
+    thread_.start();
+}
+
+EventLoop* EventLoopThread::loop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return loop_;
+}
+
+void EventLoopThread::applyPlacement()
+{
+    if (cpu_ < 0)
+    {
+        return;
+    }
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu_, &cpus);
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (err != 0)
+    {
+        LOG_ERROR("EventLoopThread绑定cpu%d失败 error:%d\n", cpu_, err);
+        return;
+    }
+    // 内存从当前运行的节点分配：进程可能被numactl设置成了交错分配，绑核之后再恢复本地分配才有意义
+    // EventLoop、poller、定时器以及之后在这个线程中增长的Buffer都是在这之后第一次访问的，会落在本地节点
+    if (syscall(SYS_set_mempolicy, MPOL_LOCAL, nullptr, 0) < 0)
+    {
+        LOG_ERROR("EventLoopThread设置本地内存分配失败 errno:%d\n", errno);
+    }
+}
+
 void EventLoopThread::threadFunc()
 {
+    applyPlacement();
     // 子线程创建EventLoop
     EventLoop loop;
     
@@ -57,6 +108,10 @@ void EventLoopThread::threadFunc()
         loop_ = &loop;
         cond_.notify_one();
     }
+    if (latch_)
+    {
+        latch_->countDown();
+    }
 
     loop.loop();
     std::unique_lock<std::mutex> lock(mutex_);
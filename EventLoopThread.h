@@ -8,6 +8,7 @@
 #include <condition_variable>
 
 class EventLoop;
+class CountDownLatch;
 
 
 class EventLoopThread : private noncopyable, private nonmoveable
@@ -18,9 +19,18 @@ public:
     EventLoopThread(const ThreadInitCallback& cb = ThreadInitCallback(), const std::string& name = std::string());
     ~EventLoopThread();
 
+    // 把loop线程绑定到cpu上，必须在startLoop之前调用，<0表示不绑定
+    void setCpuAffinity(int cpu) { cpu_ = cpu; }
+    // 启动线程并等待EventLoop创建完成
     EventLoop* startLoop();
+    // 只启动线程不等待，EventLoop创建完成后latch减一：线程池同时启动所有线程，只等待一次
+    void startLoopAsync(CountDownLatch* latch);
+    // startLoopAsync的latch返回后获取创建好的EventLoop
+    EventLoop* loop();
 private:
     void threadFunc();
+    // 在loop线程中、EventLoop构造之前执行：绑核并且内存优先从本地NUMA节点分配
+    void applyPlacement();
 
     EventLoop* loop_;
     bool exiting_;
@@ -28,6 +38,8 @@ private:
     std::mutex mutex_;
     std::condition_variable cond_;
     ThreadInitCallback callback_;
+    int cpu_;
+    CountDownLatch* latch_;
 };
 
 
@@ -1,5 +1,13 @@
 #include "EventLoopThreadPool.h"
 #include "EventLoopThread.h"
+#include "EventLoop.h"
+#include "Timestamp.h"
+#include "CountDownLatch.h"
+
+#include <algorithm>            // max
+
+// 忙碌时间的采样窗口：窗口太短时大部分loop的增量都是0，无法区分
+constexpr int64_t kBusySampleIntervalUs = 100 * 1000;
 
 
 EventLoopThreadPool::EventLoopThreadPool(EventLoop* baseLoop, const std::string& name)
@@ -7,7 +15,11 @@ EventLoopThreadPool::EventLoopThreadPool(EventLoop* baseLoop, const std::string&
     , name_(name)
     , started_(false)
     , numThreads_(0)
-    , next_(0) {}
+    , next_(0)
+    , policy_(DispatchPolicy::kRoundRobin)
+    , random_(std::random_device()())
+    , lastSampleUs_(0)
+    , busyPerConnectionUs_(1) {}
 
 EventLoopThreadPool::~EventLoopThreadPool(){}
 
@@ -15,12 +27,24 @@ void EventLoopThreadPool::start(const ThreadInitCallback& cb)
 {
     started_ = true;
 
+    // 所有线程同时启动，各自并行创建EventLoop，最后只等待一次
+    CountDownLatch latch(numThreads_);
     for (int i = 0; i < numThreads_; ++i)
     {
         char buf[name_.size() + 32];
         snprintf(buf, sizeof(buf), "%s%d", name_.c_str(), i);
-        eventLoopThreads_.push_back(std::make_unique<EventLoopThread>());
-        eventLoops_.push_back(eventLoopThreads_[i]->startLoop());
+        // 线程名：池名+序号
+        eventLoopThreads_.push_back(std::make_unique<EventLoopThread>(cb, std::string(buf)));
+        if (!cpus_.empty())
+        {
+            eventLoopThreads_[i]->setCpuAffinity(cpus_[i % cpus_.size()]);
+        }
+        eventLoopThreads_[i]->startLoopAsync(&latch);
+    }
+    latch.wait();
+    for (auto& thread : eventLoopThreads_)
+    {
+        eventLoops_.push_back(thread->loop());
     }
 
     if (numThreads_ == 0 && cb)
@@ -30,22 +54,113 @@ void EventLoopThreadPool::start(const ThreadInitCallback& cb)
     
 }
 
+void EventLoopThreadPool::stop()
+{
+    // quit排在已经投递的任务之后（例如TcpServer移除链接时投递的connectDestroyed），直接quit可能跳过它们
+    for (EventLoop* loop : eventLoops_)
+    {
+        loop->queueInLoop([loop]() { loop->quit(); });
+    }
+    eventLoops_.clear();
+    lastBusyUs_.clear();
+    recentBusyUs_.clear();
+    chargedUs_.clear();
+    next_ = 0;
+    // EventLoopThread析构时等待线程退出
+    eventLoopThreads_.clear();
+}
+
 EventLoop* EventLoopThreadPool::getNextLoop()
 {
     EventLoop* loop = baseLoop_;
 
     if (!eventLoops_.empty())
     {
-        loop = eventLoops_[next_++];
-        if (next_ >= static_cast<int>(eventLoops_.size()))
+        size_t n = eventLoops_.size();
+        size_t index = next_;
+        switch (policy_)
         {
-            next_ = 0;
+        case DispatchPolicy::kRoundRobin:
+            break;
+        case DispatchPolicy::kLeastConnections:
+            index = leastLoaded([this](size_t i) { return static_cast<int64_t>(eventLoops_[i]->connectionCount()); });
+            break;
+        case DispatchPolicy::kLeastBufferedBytes:
+            index = leastLoaded([this](size_t i) { return eventLoops_[i]->bufferedBytes(); });
+            break;
+        case DispatchPolicy::kLeastBusyTime:
+            index = leastBusy();
+            break;
+        case DispatchPolicy::kPowerOfTwoChoices:
+            if (n > 1)
+            {
+                size_t first = random_() % n;
+                // 第二个从其余n-1个中选，保证和第一个不同
+                size_t second = (first + 1 + random_() % (n - 1)) % n;
+                index = eventLoops_[second]->connectionCount() < eventLoops_[first]->connectionCount() ? second : first;
+            }
+            break;
         }
+        loop = eventLoops_[index];
+        next_ = static_cast<int>((index + 1) % n);
     }
 
     return loop;
 }
 
+template <typename LoadFunc>
+size_t EventLoopThreadPool::leastLoaded(LoadFunc load)
+{
+    size_t n = eventLoops_.size();
+    size_t best = next_;
+    int64_t bestLoad = load(best);
+    for (size_t k = 1; k < n; ++k)
+    {
+        size_t i = (next_ + k) % n;
+        int64_t l = load(i);
+        if (l < bestLoad)
+        {
+            best = i;
+            bestLoad = l;
+        }
+    }
+    return best;
+}
+
+size_t EventLoopThreadPool::leastBusy()
+{
+    sampleBusyTime();
+    size_t index = leastLoaded([this](size_t i) { return recentBusyUs_[i] + chargedUs_[i]; });
+    // 一个采样窗口内的突发链接不会全部落到同一个loop上
+    chargedUs_[index] += busyPerConnectionUs_;
+    return index;
+}
+
+void EventLoopThreadPool::sampleBusyTime()
+{
+    int64_t now = Timestamp::now().microSecondsSinceEpoch();
+    if (now - lastSampleUs_ < kBusySampleIntervalUs)
+    {
+        return;
+    }
+    lastSampleUs_ = now;
+    lastBusyUs_.resize(eventLoops_.size(), 0);
+    recentBusyUs_.resize(eventLoops_.size(), 0);
+    chargedUs_.assign(eventLoops_.size(), 0);
+    int64_t windowBusyUs = 0;
+    int64_t connections = 0;
+    for (size_t i = 0; i < eventLoops_.size(); ++i)
+    {
+        int64_t total = eventLoops_[i]->totalBusyUs();
+        recentBusyUs_[i] = total - lastBusyUs_[i];
+        lastBusyUs_[i] = total;
+        windowBusyUs += recentBusyUs_[i];
+        connections += eventLoops_[i]->connectionCount();
+    }
+    // 一个链接的估计开销：窗口内的总忙碌时间平摊到所有链接上，至少1微秒，所有loop都空闲时也能轮流分配
+    busyPerConnectionUs_ = std::max<int64_t>(1, windowBusyUs / std::max<int64_t>(1, connections));
+}
+
 
 std::vector<EventLoop*> EventLoopThreadPool::getAllLoops()
 {
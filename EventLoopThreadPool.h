@@ -6,6 +6,8 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <random>
+#include <cstdint>              // int64_t
 
 class EventLoop;
 class EventLoopThread;
@@ -14,12 +16,29 @@ class EventLoopThreadPool : private noncopyable, private nonmoveable
 {
 public:
     using ThreadInitCallback = std::function<void(EventLoop*)>;
+
+    // 新链接的分配策略，负载数据来自每个loop的统计（EventLoop::connectionCount等）
+    enum class DispatchPolicy
+    {
+        kRoundRobin,            // 轮询
+        kLeastConnections,      // 链接数最少
+        kLeastBufferedBytes,    // 输入输出缓冲区中积压的字节数最少
+        kLeastBusyTime,         // 最近一段时间处理事件花费的时间最少
+        kPowerOfTwoChoices,     // 随机选两个，取链接数少的：不需要遍历所有loop，也不会让所有新链接同时涌向同一个loop
+    };
+
     EventLoopThreadPool(EventLoop* baseLoop, const std::string& name);
     ~EventLoopThreadPool();
 
     void setThreadNum(int numThreads) { numThreads_ = numThreads; }
+    void setDispatchPolicy(DispatchPolicy policy) { policy_ = policy; }
+    // 第i个loop绑定到cpus[i % cpus.size()]，并且从本地NUMA节点分配内存，必须在start之前设置
+    void setCpuAffinity(std::vector<int> cpus) { cpus_ = std::move(cpus); }
     void start(const ThreadInitCallback& cb = ThreadInitCallback());
 
+    // 退出所有IO loop并等待线程结束，已经投递给这些loop的任务先执行完；在baseLoop中调用，之后getNextLoop只返回baseLoop
+    void stop();
+
     EventLoop* getNextLoop();
     std::vector<EventLoop*> getAllLoops();
 
@@ -27,6 +46,14 @@ public:
     const std::string name() const { return name_; }
 
 private:
+    // 从next_开始找负载最小的loop，负载相同时轮流分配
+    template <typename LoadFunc>
+    size_t leastLoaded(LoadFunc load);
+    // 每个loop在最近一个采样窗口内的忙碌时间
+    void sampleBusyTime();
+    // 按忙碌时间选择loop，并给选中的loop预先记上一个链接的估计开销
+    size_t leastBusy();
+
     EventLoop* baseLoop_;
     std::string name_;
     bool started_;
@@ -35,5 +62,16 @@ private:
     std::vector<std::unique_ptr<EventLoopThread>> eventLoopThreads_;
     std::vector<EventLoop*> eventLoops_;
 
+    std::vector<int> cpus_;
+    DispatchPolicy policy_;
+    std::minstd_rand random_;
+    // 忙碌时间的采样：上一次采样时各个loop的累计忙碌时间，以及窗口内的增量
+    int64_t lastSampleUs_;
+    std::vector<int64_t> lastBusyUs_;
+    std::vector<int64_t> recentBusyUs_;
+    // 两次采样之间新分配的链接还没有体现在忙碌时间中：每分配一个就预先记上一个链接的估计开销，下一次采样时清零
+    std::vector<int64_t> chargedUs_;
+    int64_t busyPerConnectionUs_;
+
 };
 
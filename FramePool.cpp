@@ -0,0 +1,77 @@
+#include "FramePool.h"
+
+#include <new>                  // operator new/delete
+
+
+FramePool::~FramePool()
+{
+    for (auto& list : freeLists_)
+    {
+        for (void* block : list)
+        {
+            ::operator delete(block);
+        }
+    }
+}
+
+FramePool& FramePool::local()
+{
+    static thread_local FramePool pool;
+    return pool;
+}
+
+int FramePool::sizeClass(size_t size)
+{
+    int cls = 0;
+    while (cls < kNumClasses && classSize(cls) < size)
+    {
+        ++cls;
+    }
+    return cls;
+}
+
+void* FramePool::allocate(size_t size)
+{
+    int cls = sizeClass(size + kHeaderSize);
+    void* block = nullptr;
+    if (cls < kNumClasses && !freeLists_[cls].empty())
+    {
+        block = freeLists_[cls].back();
+        freeLists_[cls].pop_back();
+        ++reused_;
+    }
+    else
+    {
+        block = ::operator new(cls < kNumClasses ? classSize(cls) : size + kHeaderSize);
+        ++allocated_;
+    }
+    *static_cast<int*>(block) = cls;
+    return static_cast<char*>(block) + kHeaderSize;
+}
+
+void FramePool::deallocate(void* ptr) noexcept
+{
+    void* block = static_cast<char*>(ptr) - kHeaderSize;
+    int cls = *static_cast<int*>(block);
+    if (cls < kNumClasses && freeLists_[cls].size() < kMaxCachedPerClass)
+    {
+        // 空闲链表的容量在第一次push时分配一次，之后不再增长
+        if (freeLists_[cls].capacity() == 0)
+        {
+            freeLists_[cls].reserve(kMaxCachedPerClass);
+        }
+        freeLists_[cls].push_back(block);
+        return;
+    }
+    ::operator delete(block);
+}
+
+size_t FramePool::cached() const
+{
+    size_t n = 0;
+    for (const auto& list : freeLists_)
+    {
+        n += list.size();
+    }
+    return n;
+}
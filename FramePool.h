@@ -0,0 +1,48 @@
+#pragma once
+#include "noncopyable.h"
+#include "nonmoveable.h"
+
+#include <cstddef>              // size_t、max_align_t
+#include <cstdint>
+#include <vector>
+
+
+/*
+协程帧的内存池，协程的promise_type通过它分配帧（见Coroutine.h）：
+1. 按128、256、...、4096字节分级，释放的帧挂在对应级别的空闲链表上，同样大小的协程反复创建不再走malloc
+2. 每个线程一个池，一个线程只运行一个loop，所以就是每个loop一个池，分配和释放都不加锁
+3. 每级最多缓存kMaxCachedPerClass个帧，突发之后多出来的帧还给系统；超过4096字节的帧直接使用operator new
+4. 帧的头部记录所属级别，在其他线程释放（协程在别的线程结束）时放进那个线程的池，也是安全的
+*/
+class FramePool : private noncopyable, private nonmoveable
+{
+public:
+    static constexpr int kNumClasses = 6;
+    static constexpr size_t kMinClassSize = 128;
+    static constexpr size_t kMaxCachedPerClass = 256;
+
+    FramePool() : allocated_(0), reused_(0) {}
+    ~FramePool();
+
+    // 当前线程的池
+    static FramePool& local();
+
+    void* allocate(size_t size);
+    void deallocate(void* ptr) noexcept;
+
+    // 向系统申请的帧数、从空闲链表复用的帧数、当前缓存的帧数
+    uint64_t allocated() const { return allocated_; }
+    uint64_t reused() const { return reused_; }
+    size_t cached() const;
+
+private:
+    // 头部保留一个max_align_t，帧本身的对齐不变
+    static constexpr size_t kHeaderSize = alignof(std::max_align_t);
+
+    static int sizeClass(size_t size);
+    static size_t classSize(int cls) { return kMinClassSize << cls; }
+
+    std::vector<void*> freeLists_[kNumClasses];
+    uint64_t allocated_;
+    uint64_t reused_;
+};
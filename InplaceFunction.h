@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstddef>              // size_t、max_align_t、nullptr_t
+#include <functional>           // function、invoke
+#include <new>                  // placement new
+#include <type_traits>
+#include <utility>              // move、forward
+
+
+// 默认的内联存储大小：能放下std::bind(std::function, shared_ptr, size_t)这类网络库里最常见的回调
+constexpr size_t kInplaceFunctionSize = 64;
+
+template <typename Signature, size_t Capacity = kInplaceFunctionSize>
+class InplaceFunction;
+
+// 可以为空的可调用对象：函数指针、成员指针、std::function，空值构造出来的InplaceFunction也是空的
+template <typename T>
+struct IsNullableCallable : std::bool_constant<std::is_pointer_v<T> || std::is_member_pointer_v<T>> {};
+template <typename Signature>
+struct IsNullableCallable<std::function<Signature>> : std::true_type {};
+
+/*
+只能移动的小对象优化回调，用来代替std::function：
+1. 可调用对象不超过Capacity并且可以noexcept移动时直接构造在对象内部的缓冲区里，不会分配堆内存；
+   std::function的内联缓冲区只有16字节，std::bind(&TcpConnection::sendInLoop, this, data, len)这样的回调每次都要new
+2. 超过Capacity的可调用对象退回到堆上，行为和std::function一样，只是多一次分配
+3. 不支持拷贝：任务投递、回调注册都是一次性的所有权转移，去掉拷贝后可以保存只能移动的对象（unique_ptr、promise）
+4. 通过一张静态的函数表完成调用、移动、析构，没有虚函数
+*/
+template <typename R, typename... Args, size_t Capacity>
+class InplaceFunction<R(Args...), Capacity>
+{
+public:
+    InplaceFunction() noexcept : ops_(nullptr) {}
+    InplaceFunction(std::nullptr_t) noexcept : ops_(nullptr) {}
+
+    template <typename F,
+              typename D = std::decay_t<F>,
+              typename = std::enable_if_t<!std::is_same_v<D, InplaceFunction> && std::is_invocable_r_v<R, D&, Args...>>>
+    InplaceFunction(F&& f)
+        : ops_(nullptr)
+    {
+        if constexpr (IsNullableCallable<D>::value)
+        {
+            if (!f)
+            {
+                return;
+            }
+        }
+        if constexpr (kFitsInline<D>)
+        {
+            new (storage_) D(std::forward<F>(f));
+            ops_ = &kInlineOps<D>;
+        }
+        else
+        {
+            *reinterpret_cast<D**>(storage_) = new D(std::forward<F>(f));
+            ops_ = &kHeapOps<D>;
+        }
+    }
+
+    InplaceFunction(InplaceFunction&& rhs) noexcept
+        : ops_(rhs.ops_)
+    {
+        if (ops_)
+        {
+            ops_->move(storage_, rhs.storage_);
+            rhs.ops_ = nullptr;
+        }
+    }
+
+    InplaceFunction& operator=(InplaceFunction&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            reset();
+            if (rhs.ops_)
+            {
+                rhs.ops_->move(storage_, rhs.storage_);
+                ops_ = rhs.ops_;
+                rhs.ops_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    InplaceFunction& operator=(std::nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    InplaceFunction(const InplaceFunction&) = delete;
+    InplaceFunction& operator=(const InplaceFunction&) = delete;
+
+    ~InplaceFunction() { reset(); }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    // 和std::function一样是const调用，保存的可调用对象本身可以有状态
+    R operator()(Args... args) const
+    {
+        return ops_->invoke(const_cast<unsigned char*>(storage_), std::forward<Args>(args)...);
+    }
+
+private:
+    struct Ops
+    {
+        R (*invoke)(void* storage, Args&&... args);
+        // 把src中的对象移动到未初始化的dst，并析构src中的对象
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template <typename D>
+    static constexpr bool kFitsInline = sizeof(D) <= Capacity
+                                     && alignof(std::max_align_t) % alignof(D) == 0
+                                     && std::is_nothrow_move_constructible_v<D>;
+
+    template <typename D>
+    static D* inlineTarget(void* storage) { return std::launder(reinterpret_cast<D*>(storage)); }
+    template <typename D>
+    static D* heapTarget(void* storage) { return *reinterpret_cast<D**>(storage); }
+
+    template <typename D>
+    static constexpr Ops kInlineOps = {
+        [](void* s, Args&&... args) -> R { return std::invoke(*inlineTarget<D>(s), std::forward<Args>(args)...); },
+        [](void* dst, void* src) noexcept {
+            D* from = inlineTarget<D>(src);
+            new (dst) D(std::move(*from));
+            from->~D();
+        },
+        [](void* s) noexcept { inlineTarget<D>(s)->~D(); },
+    };
+
+    // 堆上的对象只需要转移指针
+    template <typename D>
+    static constexpr Ops kHeapOps = {
+        [](void* s, Args&&... args) -> R { return std::invoke(*heapTarget<D>(s), std::forward<Args>(args)...); },
+        [](void* dst, void* src) noexcept { *reinterpret_cast<D**>(dst) = heapTarget<D>(src); },
+        [](void* s) noexcept { delete heapTarget<D>(s); },
+    };
+
+    void reset() noexcept
+    {
+        if (ops_)
+        {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[Capacity];
+    const Ops* ops_;
+};
@@ -0,0 +1,533 @@
+#include "IoUringPoller.h"
+#include "Logger.h"
+#include "Channel.h"
+
+#include <sys/mman.h>           // mmap、munmap
+#include <sys/syscall.h>        // __NR_io_uring_setup、__NR_io_uring_enter
+#include <unistd.h>             // close、syscall
+#include <sys/socket.h>         // MSG_NOSIGNAL
+#include <csignal>              // _NSIG
+#include <cstring>              // memset
+#include <algorithm>            // max
+
+
+// channel状态与EPollPoller保持一致
+// channel未提交poll请求，也未添加到poller的map上
+constexpr int kNew = -1;
+// channel已提交poll请求，已添加到poller的map上
+constexpr int kAdded = 1;
+// channel的poll请求已取消，但还存在poller的map上
+constexpr int kDeleted = 2;
+
+IoUringPoller::IoUringPoller(EventLoop* loop)
+    : Poller(loop)
+    , ringFd_(-1)
+    , sqRing_(nullptr)
+    , sqRingSize_(0)
+    , cqRing_(nullptr)
+    , cqRingSize_(0)
+    , sqes_(nullptr)
+    , sqesSize_(0)
+    , sqeTail_(0)
+    , nextId_(0)
+    , nextCompletionId_(0)
+    , activeChannels_(nullptr)
+    , bufferRing_(nullptr)
+    , bufferRingSize_(0)
+    , recvBuffers_(nullptr)
+    , bufferRingTail_(0)
+{
+    setupRing();
+}
+
+IoUringPoller::~IoUringPoller()
+{
+    // EventLoop析构时已经通过cancelAllCompletions释放了所有操作；关闭ring后内核不再访问缓冲区环与发送数据，剩下的操作直接释放
+    close(ringFd_);
+    completions_.clear();
+    finishedCompletions_.clear();
+    if (bufferRing_ != nullptr)
+    {
+        munmap(bufferRing_, bufferRingSize_);
+        delete[] recvBuffers_;
+    }
+    munmap(sqes_, sqesSize_);
+    if (cqRing_ != sqRing_)
+    {
+        munmap(cqRing_, cqRingSize_);
+    }
+    munmap(sqRing_, sqRingSize_);
+}
+
+void IoUringPoller::setupRing()
+{
+    memset(&params_, 0x00, sizeof(params_));
+    // 完成队列比提交队列大：一个multishot请求会产生多个完成事件
+    params_.flags = IORING_SETUP_CQSIZE;
+    params_.cq_entries = kCqEntries;
+    ringFd_ = static_cast<int>(syscall(__NR_io_uring_setup, kSqEntries, &params_));
+    if (ringFd_ < 0)
+    {
+        LOG_FATAL("io_uring_setup函数调用失败 error:%d\n", errno);
+    }
+    // 依赖的特性：IORING_FEAT_EXT_ARG带超时等待，IORING_FEAT_NODROP完成队列满时不丢事件
+    if (!(params_.features & IORING_FEAT_EXT_ARG) || !(params_.features & IORING_FEAT_NODROP))
+    {
+        LOG_FATAL("内核版本过低，io_uring不支持EXT_ARG/NODROP，features:%x\n", params_.features);
+    }
+
+    sqRingSize_ = params_.sq_off.array + params_.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params_.cq_off.cqes + params_.cq_entries * sizeof(io_uring_cqe);
+    // 新内核提交队列与完成队列可以通过一次mmap映射
+    if (params_.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        sqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+        cqRingSize_ = sqRingSize_;
+    }
+
+    sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED)
+    {
+        LOG_FATAL("io_uring提交队列mmap失败 error:%d\n", errno);
+    }
+    if (params_.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        cqRing_ = sqRing_;
+    }
+    else
+    {
+        cqRing_ = mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED)
+        {
+            LOG_FATAL("io_uring完成队列mmap失败 error:%d\n", errno);
+        }
+    }
+    sqesSize_ = params_.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        LOG_FATAL("io_uring sqe数组mmap失败 error:%d\n", errno);
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(sqRing_);
+    sqHead_ = reinterpret_cast<unsigned*>(sq + params_.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned*>(sq + params_.sq_off.tail);
+    sqMask_ = *reinterpret_cast<unsigned*>(sq + params_.sq_off.ring_mask);
+    sqArray_ = reinterpret_cast<unsigned*>(sq + params_.sq_off.array);
+    sqeTail_ = *sqTail_;
+
+    char* cq = static_cast<char*>(cqRing_);
+    cqHead_ = reinterpret_cast<unsigned*>(cq + params_.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(cq + params_.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned*>(cq + params_.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params_.cq_off.cqes);
+}
+
+int IoUringPoller::enter(unsigned toSubmit, unsigned minComplete, unsigned flags, const struct timespec* timeout)
+{
+    // 发布本地写好的sqe，内核通过sqTail_看到新的提交
+    __atomic_store_n(sqTail_, sqeTail_, __ATOMIC_RELEASE);
+
+    io_uring_getevents_arg arg;
+    memset(&arg, 0x00, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = reinterpret_cast<uint64_t>(timeout);
+    return static_cast<int>(syscall(__NR_io_uring_enter, ringFd_, toSubmit, minComplete,
+                                    flags | IORING_ENTER_EXT_ARG, &arg, sizeof(arg)));
+}
+
+io_uring_sqe* IoUringPoller::getSqe()
+{
+    unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+    // 提交队列满了：先把已有的sqe提交给内核腾出位置
+    if (sqeTail_ - head >= params_.sq_entries)
+    {
+        if (enter(sqeTail_ - head, 0, 0, nullptr) < 0)
+        {
+            LOG_FATAL("io_uring提交队列已满并且提交失败 error:%d\n", errno);
+        }
+    }
+
+    io_uring_sqe* sqe = &sqes_[sqeTail_ & sqMask_];
+    memset(sqe, 0x00, sizeof(*sqe));
+    sqArray_[sqeTail_ & sqMask_] = sqeTail_ & sqMask_;
+    ++sqeTail_;
+    return sqe;
+}
+
+void IoUringPoller::armPoll(int fd, PollRequest& request)
+{
+    // 0保留给内部操作
+    if (++nextId_ == 0)
+    {
+        ++nextId_;
+    }
+    request.id = nextId_;
+    request.armed = true;
+
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = static_cast<uint32_t>(request.channel->events());
+    sqe->user_data = encodeUserData(request.id, fd);
+}
+
+void IoUringPoller::cancelPoll(int fd, const PollRequest& request)
+{
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = encodeUserData(request.id, fd);
+    sqe->user_data = kIgnoredUserData;
+}
+
+void IoUringPoller::updateChannel(Channel* channel)
+{
+    const int index = channel->index();
+    const int fd = channel->fd();
+    LOG_INFO("func=%s => fd = %d events = %d, index=%d\n", __func__, fd, channel->events(), index);
+    if (index == kNew || index == kDeleted)
+    {
+        if (index == kNew)
+        {
+            channels_.insert(fd, channel);
+        }
+        channel->set_index(kAdded);
+        PollRequest& request = requests_[fd];
+        request.channel = channel;
+        armPoll(fd, request);
+    }
+    else
+    {
+        PollRequest& request = requests_[fd];
+        // 旧请求取消后迟到的完成事件序号对不上，会被丢弃
+        if (request.armed)
+        {
+            cancelPoll(fd, request);
+            request.armed = false;
+        }
+        if (channel->isNoneEvent())
+        {
+            request.id = 0;
+            channel->set_index(kDeleted);
+        }
+        else
+        {
+            armPoll(fd, request);
+        }
+    }
+}
+
+void IoUringPoller::removeChannel(Channel* channel)
+{
+    int fd = channel->fd();
+    channels_.erase(fd);
+    LOG_INFO("func=%s, fd=%d\n", __func__, fd);
+    auto it = requests_.find(fd);
+    if (it != requests_.end())
+    {
+        if (it->second.armed)
+        {
+            cancelPoll(fd, it->second);
+        }
+        requests_.erase(it);
+    }
+    channel->set_index(kNew);
+}
+
+void IoUringPoller::rearmFiredPolls()
+{
+    for (int fd : firedFds_)
+    {
+        auto it = requests_.find(fd);
+        // 回调中channel可能已经被移除、禁用或者通过updateChannel重新提交过
+        if (it != requests_.end() && !it->second.armed && it->second.id != 0)
+        {
+            armPoll(fd, it->second);
+        }
+    }
+    firedFds_.clear();
+}
+
+void IoUringPoller::fillActiveChannels(ChannelList* activeChannels)
+{
+    unsigned head = *cqHead_;
+    unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head)
+    {
+        const io_uring_cqe& cqe = cqes_[head & cqMask_];
+        if (cqe.user_data == kIgnoredUserData)
+        {
+            continue;
+        }
+        if (isCompletion(cqe.user_data))
+        {
+            handleCompletion(cqe);
+            continue;
+        }
+        int fd = static_cast<int>(cqe.user_data & 0xffffffff);
+        uint32_t id = static_cast<uint32_t>(cqe.user_data >> 32);
+        auto it = requests_.find(fd);
+        // channel已经被移除或者已经换了新的poll请求，丢弃旧请求的事件
+        if (it == requests_.end() || it->second.id != id || !it->second.armed)
+        {
+            continue;
+        }
+        PollRequest& request = it->second;
+        request.armed = false;
+        // 出错（如fd已经被关闭）的请求不再重新提交，直到channel下一次updateChannel
+        if (cqe.res < 0)
+        {
+            LOG_ERROR("IoUringPoller poll请求失败 fd:%d error:%d\n", fd, -cqe.res);
+            continue;
+        }
+        firedFds_.push_back(fd);
+        request.channel->set_revents(cqe.res);
+        activeChannels->push_back(request.channel);
+    }
+    __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+}
+
+Timestamp IoUringPoller::poll(int timeoutMs, ChannelList* activeChannels)
+{
+    // 忙轮询时0超时的poll非常频繁，不打印日志
+    if (timeoutMs != 0)
+    {
+        LOG_INFO("func=%s => fd total count:%lu \n", __func__, channels_.size());
+    }
+
+    struct timespec ts;
+    ts.tv_sec = timeoutMs / 1000;
+    ts.tv_nsec = (timeoutMs % 1000) * 1000 * 1000;
+
+    // 上一轮触发过的请求重新提交，和本轮积累的所有poll请求变更一起，同时等待至少一个完成事件：只有一次系统调用
+    rearmFiredPolls();
+    // 上一轮结束的操作已经处理完handleEvent，可以释放了
+    finishedCompletions_.clear();
+    unsigned toSubmit = sqeTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+    int ret = enter(toSubmit, 1, IORING_ENTER_GETEVENTS, &ts);
+    int saveError = errno;
+    Timestamp now(Timestamp::now());
+
+    if (ret < 0 && saveError != ETIME && saveError != EINTR)
+    {
+        LOG_ERROR("IoUringPoller::poll() error，errno=%d\n", saveError);
+    }
+
+    size_t before = activeChannels->size();
+    activeChannels_ = activeChannels;
+    reportedChannels_.clear();
+    fillActiveChannels(activeChannels);
+    if (activeChannels->size() > before)
+    {
+        LOG_INFO("%lu events happend \n", activeChannels->size() - before);
+    }
+    else
+    {
+        if (timeoutMs != 0)
+        {
+            LOG_DEBUG("%s timeout \n", __func__);
+        }
+    }
+    return now;
+}
+
+void IoUringPoller::setupBufferRing()
+{
+    // 缓冲区环必须页对齐，使用mmap分配
+    bufferRingSize_ = kRecvBufferCount * sizeof(io_uring_buf);
+    void* ring = mmap(nullptr, bufferRingSize_, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (ring == MAP_FAILED)
+    {
+        LOG_FATAL("io_uring缓冲区环mmap失败 error:%d\n", errno);
+    }
+    bufferRing_ = static_cast<io_uring_buf_ring*>(ring);
+
+    io_uring_buf_reg reg;
+    memset(&reg, 0x00, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(bufferRing_);
+    reg.ring_entries = kRecvBufferCount;
+    reg.bgid = kRecvBufferGroup;
+    if (syscall(__NR_io_uring_register, ringFd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+    {
+        LOG_FATAL("io_uring注册缓冲区环失败 error:%d\n", errno);
+    }
+
+    recvBuffers_ = new char[kRecvBufferCount * kRecvBufferSize];
+    for (unsigned bid = 0; bid < kRecvBufferCount; ++bid)
+    {
+        recycleBuffer(static_cast<uint16_t>(bid));
+    }
+}
+
+void IoUringPoller::recycleBuffer(uint16_t bid)
+{
+    // 不能使用bufferRing_->bufs：内核头文件的柔性数组宏在C++中会引入一个占位的空结构体，使bufs偏移8字节
+    io_uring_buf* bufs = reinterpret_cast<io_uring_buf*>(bufferRing_);
+    io_uring_buf& buf = bufs[bufferRingTail_ & (kRecvBufferCount - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(recvBuffers_ + static_cast<size_t>(bid) * kRecvBufferSize);
+    buf.len = kRecvBufferSize;
+    buf.bid = bid;
+    ++bufferRingTail_;
+    // 内核通过tail看到归还的缓冲区
+    __atomic_store_n(&bufferRing_->tail, bufferRingTail_, __ATOMIC_RELEASE);
+}
+
+void IoUringPoller::prepareRecv(int fd, uint64_t userData)
+{
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    // 不指定缓冲区，由内核从缓冲区环中选择
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kRecvBufferGroup;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->user_data = userData;
+}
+
+uint64_t IoUringPoller::submitRecv(int fd, Channel* channel, CompletionCallback cb)
+{
+    if (bufferRing_ == nullptr)
+    {
+        setupBufferRing();
+    }
+    uint64_t op = encodeUserData(++nextCompletionId_, -1);
+    completions_[op] = Completion{channel, std::move(cb), true, fd};
+    prepareRecv(fd, op);
+    return op;
+}
+
+uint64_t IoUringPoller::submitSend(int fd, Channel* channel, const char* data, size_t len, CompletionCallback cb)
+{
+    uint64_t op = encodeUserData(++nextCompletionId_, -1);
+    completions_[op] = Completion{channel, std::move(cb), false, fd};
+
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = static_cast<uint32_t>(len);
+    // 对端关闭后继续发送返回EPIPE而不是触发SIGPIPE
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = op;
+    return op;
+}
+
+void IoUringPoller::cancelCompletion(uint64_t op)
+{
+    auto it = completions_.find(op);
+    if (it == completions_.end())
+    {
+        return;
+    }
+    it->second.channel = nullptr;
+    it->second.multishot = false;
+
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = op;
+    sqe->user_data = kIgnoredUserData;
+}
+
+void IoUringPoller::cancelAllCompletions()
+{
+    std::vector<uint64_t> ops;
+    ops.reserve(completions_.size());
+    for (const auto& entry : completions_)
+    {
+        ops.push_back(entry.first);
+    }
+    for (uint64_t op : ops)
+    {
+        cancelCompletion(op);
+    }
+
+    // 等待被取消的操作结束，最多等1秒；期间到达的就绪事件直接丢弃
+    ChannelList discarded;
+    activeChannels_ = &discarded;
+    struct timespec ts;
+    ts.tv_sec = 0;
+    ts.tv_nsec = 100 * 1000 * 1000;
+    for (int i = 0; i < 10 && !completions_.empty(); ++i)
+    {
+        unsigned toSubmit = sqeTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+        if (enter(toSubmit, 1, IORING_ENTER_GETEVENTS, &ts) < 0 && errno != ETIME && errno != EINTR)
+        {
+            LOG_ERROR("IoUringPoller::cancelAllCompletions() error，errno=%d\n", errno);
+            break;
+        }
+        fillActiveChannels(&discarded);
+        discarded.clear();
+    }
+    activeChannels_ = nullptr;
+    if (!completions_.empty())
+    {
+        LOG_ERROR("IoUringPoller::cancelAllCompletions() %lu个操作没有在超时前结束\n", completions_.size());
+    }
+    completions_.clear();
+    finishedCompletions_.clear();
+}
+
+void IoUringPoller::handleCompletion(const io_uring_cqe& cqe)
+{
+    auto it = completions_.find(cqe.user_data);
+    if (it == completions_.end())
+    {
+        return;
+    }
+    Completion& completion = it->second;
+
+    const char* data = nullptr;
+    bool hasBuffer = cqe.flags & IORING_CQE_F_BUFFER;
+    uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+    if (hasBuffer)
+    {
+        data = recvBuffers_ + static_cast<size_t>(bid) * kRecvBufferSize;
+    }
+
+    // 缓冲区环暂时用完（-ENOBUFS）不是错误，缓冲区在本轮就会归还，重新提交即可
+    bool noBuffer = completion.multishot && cqe.res == -ENOBUFS;
+    if (completion.channel != nullptr && !noBuffer)
+    {
+        int revents = completion.callback(cqe.res, data);
+        if (revents != 0 && completion.channel != nullptr)
+        {
+            reportChannel(completion.channel, revents);
+        }
+    }
+    // 回调已经把数据拷贝走，立刻归还缓冲区
+    if (hasBuffer)
+    {
+        recycleBuffer(bid);
+    }
+
+    if (!(cqe.flags & IORING_CQE_F_MORE))
+    {
+        // multishot recv在仍然可以继续接收的情况下被内核结束（缓冲区用完等），使用同一个句柄重新提交
+        if (completion.multishot && (cqe.res > 0 || noBuffer))
+        {
+            prepareRecv(completion.fd, cqe.user_data);
+        }
+        else
+        {
+            finishedCompletions_.push_back(std::move(completion));
+            // 回调中可能提交了新的操作导致rehash，it可能已经失效，按key删除
+            completions_.erase(cqe.user_data);
+        }
+    }
+}
+
+void IoUringPoller::reportChannel(Channel* channel, int revents)
+{
+    if (reportedChannels_.insert(channel).second)
+    {
+        channel->set_revents(revents);
+        activeChannels_->push_back(channel);
+    }
+    else
+    {
+        channel->set_revents(channel->revents() | revents);
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include "Poller.h"
+
+#include <linux/io_uring.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include <vector>
+#include <cstdint>              // uint64_t
+
+
+/*
+基于io_uring的IO复用：
+1. 每个channel对应一个IORING_OP_POLL_ADD请求，channel的添加、修改、删除只是往提交队列里写sqe，不会立刻进入内核，
+   统一在下一次poll时和等待操作一起通过一次io_uring_enter提交，修改监听事件（enableWriting/disableWriting）不再是一次epoll_ctl系统调用
+2. 为什么不使用multishot poll？multishot poll是边沿触发的，并且内核不允许和IORING_POLL_ADD_LEVEL一起使用，
+   而TcpConnection依赖水平触发（一次readFd不一定读完）。所以使用单次poll请求，触发后在下一次poll时随等待一起重新提交：
+   重新提交时内核会立刻检查fd是否仍然就绪，效果等同于水平触发，并且同样不需要额外的系统调用
+3. 没有使用liburing，直接通过系统调用与mmap操作提交队列和完成队列
+4. 除了就绪通知，还提供完成模式的收发（submitRecv/submitSend）：
+   接收使用multishot IORING_OP_RECV + 注册的缓冲区环（provided buffer ring），一个请求持续接收数据，不需要每次都readv
+   发送使用IORING_OP_SEND，和其他sqe一起随下一次poll批量提交
+   完成事件的回调在poll中执行，回调返回的事件通过对应的channel上报，和就绪事件一样在handleEvent中处理
+*/
+class IoUringPoller : public Poller
+{
+public:
+    IoUringPoller(EventLoop* loop);
+    ~IoUringPoller() override;
+
+    Timestamp poll(int timeoutMs, ChannelList* activeChannels) override;
+    void updateChannel(Channel* channel) override;
+    void removeChannel(Channel* channel) override;
+
+    // 完成模式的回调：res为cqe.res，data为接收到的数据（只有recv有）；返回需要通过channel上报的事件，0表示不上报
+    using CompletionCallback = std::function<int(int res, const char* data)>;
+
+    // 在fd上持续接收数据，直到对端关闭、出错或者被取消，返回操作的句柄
+    uint64_t submitRecv(int fd, Channel* channel, CompletionCallback cb);
+    // 发送[data, data+len)，完成前data必须保持有效
+    uint64_t submitSend(int fd, Channel* channel, const char* data, size_t len, CompletionCallback cb);
+    // 取消操作：之后不会再通过channel上报事件，但回调（以及它持有的对象）要等内核确认结束后才释放
+    void cancelCompletion(uint64_t op);
+    // 取消所有操作，等内核确认结束后释放回调持有的对象；EventLoop析构时在其他成员销毁之前调用
+    void cancelAllCompletions();
+
+private:
+    // 一个channel当前在内核中的poll请求
+    struct PollRequest
+    {
+        Channel* channel;
+        // 请求的序号，channel每次修改事件都会换一个新序号，旧请求迟到的完成事件通过序号识别并丢弃
+        uint32_t id;
+        // 请求是否还在内核中等待，触发后需要重新提交
+        bool armed;
+    };
+
+    // 一个完成模式的操作
+    struct Completion
+    {
+        Channel* channel;
+        CompletionCallback callback;
+        // multishot recv因为缓冲区用完等原因结束时需要重新提交
+        bool multishot;
+        int fd;
+    };
+
+    // user_data = 序号 << 32 | fd
+    static uint64_t encodeUserData(uint32_t id, int fd) { return (static_cast<uint64_t>(id) << 32) | static_cast<uint32_t>(fd); }
+
+    // 完成模式的操作fd部分固定为-1，和poll请求区分
+    static bool isCompletion(uint64_t userData) { return (userData & 0xffffffff) == 0xffffffff; }
+
+    void setupRing();
+    // 第一次submitRecv时才注册缓冲区环，只使用就绪通知的loop不占用这部分内存
+    void setupBufferRing();
+    void prepareRecv(int fd, uint64_t userData);
+    void recycleBuffer(uint16_t bid);
+    void handleCompletion(const io_uring_cqe& cqe);
+    // 完成模式上报的channel合并到活跃channel中
+    void reportChannel(Channel* channel, int revents);
+    io_uring_sqe* getSqe();
+    // 提交sqe、等待完成事件
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags, const struct timespec* timeout);
+    void armPoll(int fd, PollRequest& request);
+    void cancelPoll(int fd, const PollRequest& request);
+    void rearmFiredPolls();
+    void fillActiveChannels(ChannelList* activeChannels);
+
+    static constexpr unsigned kSqEntries = 256;
+    static constexpr unsigned kCqEntries = 4096;
+    // 内部操作（POLL_REMOVE）的user_data，完成事件直接忽略
+    static constexpr uint64_t kIgnoredUserData = 0;
+    // 缓冲区环：kRecvBufferCount个kRecvBufferSize大小的缓冲区，数量必须是2的幂
+    static constexpr unsigned kRecvBufferCount = 256;
+    static constexpr unsigned kRecvBufferSize = 16 * 1024;
+    static constexpr uint16_t kRecvBufferGroup = 0;
+
+    int ringFd_;
+    io_uring_params params_;
+
+    // mmap映射的提交队列、完成队列、sqe数组
+    void* sqRing_;
+    size_t sqRingSize_;
+    void* cqRing_;
+    size_t cqRingSize_;
+    io_uring_sqe* sqes_;
+    size_t sqesSize_;
+
+    unsigned* sqHead_;
+    unsigned* sqTail_;
+    unsigned sqMask_;
+    unsigned* sqArray_;
+    // 本地维护的提交队列尾，poll时一次性发布给内核
+    unsigned sqeTail_;
+
+    unsigned* cqHead_;
+    unsigned* cqTail_;
+    unsigned cqMask_;
+    io_uring_cqe* cqes_;
+
+    uint32_t nextId_;
+    std::unordered_map<int, PollRequest> requests_;
+    // 上一次poll中触发过的fd，下一次poll时重新提交
+    std::vector<int> firedFds_;
+
+    uint32_t nextCompletionId_;
+    std::unordered_map<uint64_t, Completion> completions_;
+    // 本轮已经结束的操作：回调持有的对象（如TcpConnection）要保留到本轮handleEvent结束，下一次poll时释放
+    std::vector<Completion> finishedCompletions_;
+    // 本轮已经上报的channel，同一个channel的多个完成事件合并成一个
+    std::unordered_set<Channel*> reportedChannels_;
+    ChannelList* activeChannels_;
+
+    io_uring_buf_ring* bufferRing_;
+    size_t bufferRingSize_;
+    char* recvBuffers_;
+    uint16_t bufferRingTail_;
+};
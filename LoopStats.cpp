@@ -0,0 +1,153 @@
+#include "LoopStats.h"
+
+#include <cstdio>               // snprintf
+
+
+Histogram::Histogram()
+    : sum_(0)
+    , max_(0)
+{
+    for (auto& bucket : buckets_)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+int Histogram::bucketIndex(uint64_t value)
+{
+    if (value < kSubBuckets)
+    {
+        return static_cast<int>(value);
+    }
+    // 最高位所在的2的幂区间，再取最高位之后的kSubBucketBits位作为区间内的线性桶
+    int exponent = 63 - __builtin_clzll(value);
+    int sub = static_cast<int>((value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1));
+    return kSubBuckets + (exponent - kSubBucketBits) * kSubBuckets + sub;
+}
+
+uint64_t Histogram::bucketUpperBound(int index)
+{
+    if (index < kSubBuckets)
+    {
+        return static_cast<uint64_t>(index);
+    }
+    int exponent = (index - kSubBuckets) / kSubBuckets + kSubBucketBits;
+    uint64_t sub = static_cast<uint64_t>((index - kSubBuckets) % kSubBuckets);
+    uint64_t width = uint64_t(1) << (exponent - kSubBucketBits);
+    uint64_t lower = (uint64_t(1) << exponent) + sub * width;
+    return lower + (width - 1);
+}
+
+void Histogram::record(uint64_t value)
+{
+    std::atomic<uint64_t>& bucket = buckets_[bucketIndex(value)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    sum_.store(sum_.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    if (value > max_.load(std::memory_order_relaxed))
+    {
+        max_.store(value, std::memory_order_relaxed);
+    }
+}
+
+Histogram::Snapshot Histogram::snapshot() const
+{
+    Snapshot snap;
+    for (int i = 0; i < kBuckets; ++i)
+    {
+        snap.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        // 总数由各个桶累加，百分位计算时和桶保持一致
+        snap.count += snap.buckets[i];
+    }
+    snap.sum = sum_.load(std::memory_order_relaxed);
+    snap.max = max_.load(std::memory_order_relaxed);
+    return snap;
+}
+
+uint64_t Histogram::Snapshot::percentile(double p) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    // 至少要覆盖rank个样本
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * count + 0.5);
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+        {
+            uint64_t upper = bucketUpperBound(i);
+            return upper < max ? upper : max;
+        }
+    }
+    return max;
+}
+
+std::string LoopStatsSnapshot::toString() const
+{
+    char buf[512];
+    snprintf(buf, sizeof(buf),
+             "iterations=%lu wakeups=%lu functors=%lu blocked=%ldus busy=%ldus "
+             "batch(mean=%.1f p99=%lu max=%lu) pollWait(p50=%luus p99=%luus) "
+             "handler(p50=%luus p99=%luus max=%luus) functor(p99=%luus max=%luus) queueDepth(p99=%lu max=%lu)",
+             iterations, wakeups, functors, blockedUs, busyUs,
+             pollBatch.mean(), pollBatch.percentile(99), pollBatch.max,
+             pollWaitUs.percentile(50), pollWaitUs.percentile(99),
+             handlerUs.percentile(50), handlerUs.percentile(99), handlerUs.max,
+             functorUs.percentile(99), functorUs.max,
+             queueDepth.percentile(99), queueDepth.max);
+    return buf;
+}
+
+LoopStats::LoopStats()
+    : iterations_(0)
+    , wakeups_(0)
+    , functors_(0)
+    , blockedUs_(0)
+    , busyUs_(0) {}
+
+void LoopStats::recordPoll(int64_t waitUs, size_t numEvents)
+{
+    add(iterations_, 1);
+    add(blockedUs_, static_cast<uint64_t>(waitUs));
+    pollWaitUs_.record(static_cast<uint64_t>(waitUs));
+    pollBatch_.record(numEvents);
+}
+
+void LoopStats::recordHandlers(int64_t us)
+{
+    handlerUs_.record(static_cast<uint64_t>(us));
+}
+
+void LoopStats::recordFunctors(size_t count, int64_t us)
+{
+    add(functors_, count);
+    queueDepth_.record(count);
+    functorUs_.record(static_cast<uint64_t>(us));
+}
+
+void LoopStats::recordBusy(int64_t us)
+{
+    add(busyUs_, static_cast<uint64_t>(us));
+}
+
+LoopStatsSnapshot LoopStats::snapshot() const
+{
+    LoopStatsSnapshot snap;
+    snap.iterations = iterations_.load(std::memory_order_relaxed);
+    snap.wakeups = wakeups_.load(std::memory_order_relaxed);
+    snap.functors = functors_.load(std::memory_order_relaxed);
+    snap.blockedUs = static_cast<int64_t>(blockedUs_.load(std::memory_order_relaxed));
+    snap.busyUs = static_cast<int64_t>(busyUs_.load(std::memory_order_relaxed));
+    snap.pollBatch = pollBatch_.snapshot();
+    snap.pollWaitUs = pollWaitUs_.snapshot();
+    snap.handlerUs = handlerUs_.snapshot();
+    snap.functorUs = functorUs_.snapshot();
+    snap.queueDepth = queueDepth_.snapshot();
+    return snap;
+}
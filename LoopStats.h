@@ -0,0 +1,116 @@
+#pragma once
+#include "noncopyable.h"
+#include "nonmoveable.h"
+
+#include <atomic>
+#include <array>
+#include <cstdint>              // uint64_t、int64_t
+#include <string>
+
+
+/*
+对数线性直方图：小于4的值各占一个桶，之后每个2的幂区间再线性分成4个桶，相对误差不超过25%
+覆盖整个uint64_t只需要252个桶，记录一次只是一次数组下标计算和几次relaxed读写
+只有一个写线程（loop线程），任意线程都可以snapshot
+*/
+class Histogram : private noncopyable, private nonmoveable
+{
+public:
+    static constexpr int kSubBucketBits = 2;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kBuckets = kSubBuckets + (64 - kSubBucketBits) * kSubBuckets;
+
+    struct Snapshot
+    {
+        std::array<uint64_t, kBuckets> buckets{};
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t max = 0;
+
+        double mean() const { return count == 0 ? 0.0 : static_cast<double>(sum) / count; }
+        // 第p（0~100）百分位所在桶的上界，不会低估
+        uint64_t percentile(double p) const;
+    };
+
+    Histogram();
+
+    // 只能在写线程调用
+    void record(uint64_t value);
+    Snapshot snapshot() const;
+
+    static int bucketIndex(uint64_t value);
+    // 桶中最大的值
+    static uint64_t bucketUpperBound(int index);
+
+private:
+    std::atomic<uint64_t> buckets_[kBuckets];
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> max_;
+};
+
+// 某一时刻的统计拷贝，可以在任意线程读取、打印
+struct LoopStatsSnapshot
+{
+    // 循环次数
+    uint64_t iterations = 0;
+    // 真正写了eventfd、把loop从poll中唤醒的次数
+    uint64_t wakeups = 0;
+    // 执行的跨线程任务总数
+    uint64_t functors = 0;
+    // 阻塞（包括忙轮询自旋）在poll中的时间、处理事件和任务的时间，单位微秒
+    int64_t blockedUs = 0;
+    int64_t busyUs = 0;
+
+    // 每次poll返回的事件数
+    Histogram::Snapshot pollBatch;
+    // 每次poll等待的时间，单位微秒
+    Histogram::Snapshot pollWaitUs;
+    // 每轮处理IO事件回调的时间，单位微秒
+    Histogram::Snapshot handlerUs;
+    // 每轮执行任务的时间，单位微秒
+    Histogram::Snapshot functorUs;
+    // 每轮取出的任务数，即任务队列的深度
+    Histogram::Snapshot queueDepth;
+
+    std::string toString() const;
+};
+
+/*
+EventLoop的运行统计：
+1. 所有计数只有loop线程写，使用relaxed读写而不是原子读改写，几乎没有额外开销
+2. 单独对齐到缓存行，其他线程读取统计不会和EventLoop中其他频繁修改的成员伪共享
+*/
+class alignas(64) LoopStats : private noncopyable, private nonmoveable
+{
+public:
+    LoopStats();
+
+    // 以下只能在loop线程调用
+    void recordPoll(int64_t waitUs, size_t numEvents);
+    void recordHandlers(int64_t us);
+    void recordFunctors(size_t count, int64_t us);
+    void recordBusy(int64_t us);
+    void recordWakeup() { add(wakeups_, 1); }
+
+    int64_t busyUs() const { return static_cast<int64_t>(busyUs_.load(std::memory_order_relaxed)); }
+    // 线程安全
+    LoopStatsSnapshot snapshot() const;
+
+private:
+    static void add(std::atomic<uint64_t>& counter, uint64_t delta)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> iterations_;
+    std::atomic<uint64_t> wakeups_;
+    std::atomic<uint64_t> functors_;
+    std::atomic<uint64_t> blockedUs_;
+    std::atomic<uint64_t> busyUs_;
+
+    Histogram pollBatch_;
+    Histogram pollWaitUs_;
+    Histogram handlerUs_;
+    Histogram functorUs_;
+    Histogram queueDepth_;
+};
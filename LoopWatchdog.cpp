@@ -0,0 +1,135 @@
+#include "LoopWatchdog.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "Timestamp.h"
+
+#include <chrono>
+#include <cstdio>               // snprintf
+
+
+const char* loopActivityName(LoopActivity activity)
+{
+    switch (activity)
+    {
+    case LoopActivity::kIdle: return "idle";
+    case LoopActivity::kRead: return "read";
+    case LoopActivity::kWrite: return "write";
+    case LoopActivity::kClose: return "close";
+    case LoopActivity::kError: return "error";
+    case LoopActivity::kFunctor: return "functor";
+    }
+    return "unknown";
+}
+
+std::string LoopStall::toString() const
+{
+    char buf[256];
+    snprintf(buf, sizeof(buf), "loop %p (tid %d) %s %s callback fd=%d%s%s for %ldms",
+             static_cast<void*>(loop), tid, finished ? "finished slow" : "stalled in",
+             loopActivityName(activity), fd, name.empty() ? "" : " name=", name.c_str(), elapsedUs / 1000);
+    return buf;
+}
+
+LoopWatchdog::LoopWatchdog(int thresholdMs, int checkIntervalMs)
+    : thresholdMs_(thresholdMs > 0 ? thresholdMs : 1)
+    , checkIntervalMs_(checkIntervalMs > 0 ? checkIntervalMs : (thresholdMs_ / 2 > 0 ? thresholdMs_ / 2 : 1))
+    , reporter_(std::make_shared<Reporter>())
+    , running_(false)
+    , thread_(std::bind(&LoopWatchdog::threadFunc, this), "LoopWatchdog") {}
+
+LoopWatchdog::~LoopWatchdog()
+{
+    stop();
+}
+
+void LoopWatchdog::watch(EventLoop* loop)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        loops_.push_back(Watched{loop, 0});
+    }
+    // 执行完的慢回调由loop线程自己报告：在loop线程中打开检测
+    int64_t thresholdUs = static_cast<int64_t>(thresholdMs_) * 1000;
+    std::shared_ptr<Reporter> reporter = reporter_;
+    loop->runInLoop([loop, thresholdUs, reporter]() {
+        loop->setStallDetection(thresholdUs, [reporter](const LoopStall& stall) { reporter->report(stall); });
+    });
+}
+
+void LoopWatchdog::start()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        running_ = true;
+    }
+    thread_.start();
+}
+
+void LoopWatchdog::stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!running_)
+        {
+            return;
+        }
+        running_ = false;
+    }
+    cond_.notify_all();
+    thread_.join();
+}
+
+void LoopWatchdog::threadFunc()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_)
+    {
+        cond_.wait_for(lock, std::chrono::milliseconds(checkIntervalMs_));
+        if (!running_)
+        {
+            break;
+        }
+        std::vector<LoopStall> stalls = check();
+        // 在锁外报告，回调中可以继续watch
+        lock.unlock();
+        for (const LoopStall& stall : stalls)
+        {
+            reporter_->report(stall);
+        }
+        lock.lock();
+    }
+}
+
+std::vector<LoopStall> LoopWatchdog::check()
+{
+    std::vector<LoopStall> stalls;
+    int64_t nowUs = Timestamp::now().microSecondsSinceEpoch();
+    int64_t thresholdUs = static_cast<int64_t>(thresholdMs_) * 1000;
+    for (Watched& watched : loops_)
+    {
+        LoopStall stall;
+        uint64_t seq = 0;
+        int64_t startUs = watched.loop->currentActivity(&stall, &seq);
+        if (startUs == 0 || seq == watched.reportedSeq || nowUs - startUs < thresholdUs)
+        {
+            continue;
+        }
+        watched.reportedSeq = seq;
+        stall.elapsedUs = nowUs - startUs;
+        stalls.push_back(std::move(stall));
+    }
+    return stalls;
+}
+
+void LoopWatchdog::Reporter::report(const LoopStall& stall)
+{
+    stalls.fetch_add(1, std::memory_order_relaxed);
+    if (callback)
+    {
+        callback(stall);
+    }
+    else
+    {
+        LOG_ERROR("LoopWatchdog: %s\n", stall.toString().c_str());
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include "noncopyable.h"
+#include "nonmoveable.h"
+#include "Thread.h"
+
+#include <sys/types.h>          // pid_t
+#include <cstdint>              // int64_t、uint64_t
+#include <string>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>               // shared_ptr
+
+class EventLoop;
+
+
+// loop当前正在执行的回调类型
+enum class LoopActivity : int
+{
+    kIdle,
+    kRead,
+    kWrite,
+    kClose,
+    kError,
+    kFunctor,
+};
+const char* loopActivityName(LoopActivity activity);
+
+// 一次卡顿：哪个loop、哪个fd、哪种回调、持续了多久
+struct LoopStall
+{
+    EventLoop* loop = nullptr;
+    pid_t tid = 0;
+    // 任务没有fd，为-1
+    int fd = -1;
+    LoopActivity activity = LoopActivity::kIdle;
+    int64_t elapsedUs = 0;
+    /*
+    false：watchdog线程发现回调仍在执行，只能读到原子变量中的fd和回调类型
+    true：慢回调执行完后由loop线程报告，可以安全地带上channel的名字（TcpConnection的名字）
+    */
+    bool finished = false;
+    std::string name;
+
+    std::string toString() const;
+};
+
+/*
+loop卡顿检测：一个慢的messageCallback会阻塞同一个loop上的所有链接
+1. loop在每个回调前后更新心跳（开始时间、fd、回调类型），watchdog线程周期性检查，回调执行超过阈值时立即报告，
+   回调一直不返回（死循环、死锁）也能发现
+2. 同一次回调只报告一次；慢回调结束后loop线程再报告一次完整的耗时和链接名字
+3. 没有被watch的loop只多一次bool判断
+默认通过LOG_ERROR输出，也可以设置回调自行处理；卡顿回调可能在watchdog线程或者loop线程执行
+*/
+class LoopWatchdog : private noncopyable, private nonmoveable
+{
+public:
+    using StallCallback = std::function<void(const LoopStall&)>;
+
+    // checkIntervalMs<=0时取阈值的一半
+    explicit LoopWatchdog(int thresholdMs = 100, int checkIntervalMs = 0);
+    ~LoopWatchdog();
+
+    // 必须在start之前调用
+    void setStallCallback(StallCallback cb) { reporter_->callback = std::move(cb); }
+    // 开始监控loop，线程安全；loop必须比watchdog活得久，检测在loop线程中打开，loop还没运行时等loop开始后生效
+    void watch(EventLoop* loop);
+
+    void start();
+    void stop();
+
+    // 发现的卡顿次数（包括执行中和执行完的报告）
+    uint64_t stalls() const { return reporter_->stalls.load(std::memory_order_relaxed); }
+    int thresholdMs() const { return thresholdMs_; }
+
+private:
+    // loop线程也会报告执行完的慢回调，和loop共享所有权：watchdog先析构时loop仍然可以安全报告
+    struct Reporter
+    {
+        Reporter() : stalls(0) {}
+        void report(const LoopStall& stall);
+
+        StallCallback callback;
+        std::atomic<uint64_t> stalls;
+    };
+
+    struct Watched
+    {
+        EventLoop* loop;
+        // 已经报告过的回调序号，同一次回调只报告一次
+        uint64_t reportedSeq;
+    };
+
+    void threadFunc();
+    // 持有mutex_调用，返回需要报告的卡顿
+    std::vector<LoopStall> check();
+
+    const int thresholdMs_;
+    const int checkIntervalMs_;
+    std::shared_ptr<Reporter> reporter_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool running_;
+    std::vector<Watched> loops_;
+    Thread thread_;
+};
@@ -0,0 +1,184 @@
+#pragma once
+#include "noncopyable.h"
+#include "nonmoveable.h"
+
+#include <atomic>
+#include <cstdint>              // uint32_t、uint64_t
+#include <utility>              // move
+
+
+/*
+无锁多生产者单消费者队列（Vyukov MPSC）：
+1. 生产者push只有一次原子exchange（抢到链表头）和一次release store（把前一个节点链到自己），没有锁也没有CAS重试，
+   多个线程同时向同一个loop投递任务不会在一把互斥锁上排队
+2. 消费者pop只读写自己的tail_，不需要任何原子读改写
+3. 链表中始终有一个哑节点（stub），队列为空时head_和tail_都指向它，push和pop不需要处理空队列的特殊情况
+4. 生产者exchange之后、链接next之前的短暂窗口内，消费者会认为队列已经空了：这个节点要等生产者链接完成后才能取出，
+   EventLoop中生产者push后会wakeup，所以不会丢任务
+5. 节点循环使用：消费者把取完的节点还到每个队列自己的空闲栈上，生产者从栈上取，稳定状态下push/pop不分配内存
+   空闲栈的节点按kChunkSize个一组分配，栈顶是 序号 | 版本号 的64位整数，生产者并发出栈时用版本号避免ABA；
+   空闲栈空了生产者才new一个节点，这个节点被消费者回收时如果空闲栈仍然是空的就补一组节点，最多kMaxChunks组
+只有一个线程可以调用pop/empty（EventLoop所在线程），push可以在任意线程调用；T被移动之后应该为空，不在空闲节点上持有资源
+*/
+template <typename T>
+class MpscQueue : private noncopyable, private nonmoveable
+{
+public:
+    static constexpr uint32_t kChunkSize = 64;
+    static constexpr uint32_t kMaxChunks = 64;
+
+    MpscQueue()
+        : head_(new Node())
+        , freeHead_(pack(kNoIndex, 0))
+        , heapNodes_(1)
+        , tail_(head_.load(std::memory_order_relaxed))
+        , numChunks_(0)
+    {
+        for (auto& chunk : chunks_)
+        {
+            chunk.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~MpscQueue()
+    {
+        T value;
+        while (pop(value)) {}
+        if (tail_->index == kNoIndex)
+        {
+            delete tail_;
+        }
+        for (uint32_t i = 0; i < numChunks_; ++i)
+        {
+            delete[] chunks_[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    // 任意线程调用
+    void push(T value)
+    {
+        Node* node = allocateNode();
+        node->next.store(nullptr, std::memory_order_relaxed);
+        node->value = std::move(value);
+        // 抢到链表头之后再把前一个节点链接过来，release保证消费者看到next时value已经构造完成
+        Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // 只能在消费者线程调用，队列为空返回false
+    bool pop(T& value)
+    {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr)
+        {
+            return false;
+        }
+        // next成为新的哑节点，它的值已经被取走
+        value = std::move(next->value);
+        tail_ = next;
+        releaseNode(tail);
+        return true;
+    }
+
+    // 只能在消费者线程调用
+    bool empty() const
+    {
+        return tail_->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+    // 空闲栈为空时new出来的节点数（包括初始的哑节点），任意线程读取
+    uint64_t heapNodes() const { return heapNodes_.load(std::memory_order_relaxed); }
+
+private:
+    // 不属于任何一组的节点（new出来的）的序号
+    static constexpr uint32_t kNoIndex = 0xffffffff;
+
+    struct Node
+    {
+        Node() : next(nullptr), freeNext(kNoIndex), index(kNoIndex) {}
+
+        std::atomic<Node*> next;
+        // 空闲栈中下一个节点的序号：生产者出栈时可能读到被并发修改的值，由栈顶的版本号判断是否有效
+        std::atomic<uint32_t> freeNext;
+        uint32_t index;
+        T value;
+    };
+
+    static uint64_t pack(uint32_t index, uint32_t tag) { return (static_cast<uint64_t>(tag) << 32) | index; }
+    static uint32_t indexOf(uint64_t top) { return static_cast<uint32_t>(top); }
+    static uint32_t tagOf(uint64_t top) { return static_cast<uint32_t>(top >> 32); }
+
+    Node* nodeAt(uint32_t index) const
+    {
+        return &chunks_[index / kChunkSize].load(std::memory_order_acquire)[index % kChunkSize];
+    }
+
+    // 生产者调用：从空闲栈出栈，栈空时new
+    Node* allocateNode()
+    {
+        uint64_t top = freeHead_.load(std::memory_order_acquire);
+        while (indexOf(top) != kNoIndex)
+        {
+            Node* node = nodeAt(indexOf(top));
+            uint64_t next = pack(node->freeNext.load(std::memory_order_relaxed), tagOf(top) + 1);
+            if (freeHead_.compare_exchange_weak(top, next, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                return node;
+            }
+        }
+        heapNodes_.fetch_add(1, std::memory_order_relaxed);
+        return new Node();
+    }
+
+    // 消费者调用：把[first, last]这一串已经通过freeNext链好的节点压回空闲栈
+    void pushFree(Node* first, Node* last)
+    {
+        uint64_t top = freeHead_.load(std::memory_order_relaxed);
+        do
+        {
+            last->freeNext.store(indexOf(top), std::memory_order_relaxed);
+        } while (!freeHead_.compare_exchange_weak(top, pack(first->index, tagOf(top) + 1),
+                                                  std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // 消费者调用：回收不再作为哑节点的节点
+    void releaseNode(Node* node)
+    {
+        if (node->index != kNoIndex)
+        {
+            pushFree(node, node);
+            return;
+        }
+        delete node;
+        // 空闲栈已经用完了才补一组节点，一次突发只补一组，节点数跟着稳定状态的积压量增长
+        if (numChunks_ < kMaxChunks && indexOf(freeHead_.load(std::memory_order_relaxed)) == kNoIndex)
+        {
+            Node* chunk = new Node[kChunkSize];
+            for (uint32_t i = 0; i < kChunkSize; ++i)
+            {
+                chunk[i].index = numChunks_ * kChunkSize + i;
+                if (i + 1 < kChunkSize)
+                {
+                    chunk[i].freeNext.store(chunk[i].index + 1, std::memory_order_relaxed);
+                }
+            }
+            // 先发布这一组的地址，生产者通过栈顶拿到序号时一定能找到节点
+            chunks_[numChunks_].store(chunk, std::memory_order_release);
+            ++numChunks_;
+            pushFree(&chunk[0], &chunk[kChunkSize - 1]);
+        }
+    }
+
+    // 生产者竞争的链表头，单独占一个缓存行，避免和消费者的tail_伪共享
+    alignas(64) std::atomic<Node*> head_;
+    // 空闲栈栈顶：序号 | 版本号 << 32
+    alignas(64) std::atomic<uint64_t> freeHead_;
+    std::atomic<uint64_t> heapNodes_;
+    // 消费者独占
+    alignas(64) Node* tail_;
+    // 已经分配的组数，只有消费者修改
+    uint32_t numChunks_;
+    // 生产者通过序号读取，组在队列析构前不释放
+    std::atomic<Node*> chunks_[kMaxChunks];
+};
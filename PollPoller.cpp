@@ -0,0 +1,120 @@
+#include "PollPoller.h"
+#include "Logger.h"
+#include "Channel.h"
+
+#include <algorithm>            // iter_swap
+
+
+// channel未添加到pollfd数组，也未添加到poller的map上；已添加的channel的index是它在pollfd数组中的下标
+constexpr int kNew = -1;
+
+PollPoller::PollPoller(EventLoop* loop)
+    : Poller(loop) {}
+
+Timestamp PollPoller::poll(int timeoutMs, ChannelList* activeChannels)
+{
+    // 忙轮询时0超时的poll非常频繁，不打印日志
+    if (timeoutMs != 0)
+    {
+        LOG_INFO("func=%s => fd total count:%lu \n", __func__, pollfds_.size());
+    }
+
+    int numEvents = ::poll(pollfds_.data(), pollfds_.size(), timeoutMs);
+    int saveError = errno;
+    Timestamp now(Timestamp::now());
+
+    if (numEvents > 0)
+    {
+        LOG_INFO("%d events happend \n", numEvents);
+        fillActiveChannels(numEvents, activeChannels);
+    }
+    else if (numEvents == 0)
+    {
+        if (timeoutMs != 0)
+        {
+            LOG_DEBUG("%s timeout \n", __func__);
+        }
+    }
+    else
+    {
+        if (saveError != EINTR)
+        {
+            LOG_ERROR("PollPoller::poll() error，errno=%d\n", saveError);
+        }
+    }
+    return now;
+}
+
+void PollPoller::fillActiveChannels(int numEvents, ChannelList* activeChannels) const
+{
+    // numEvents个fd有事件，找到这么多个就可以提前结束
+    for (auto pfd = pollfds_.begin(); pfd != pollfds_.end() && numEvents > 0; ++pfd)
+    {
+        if (pfd->revents > 0)
+        {
+            --numEvents;
+            Channel* channel = channels_.find(pfd->fd);
+            if (channel != nullptr)
+            {
+                // poll的POLLIN/POLLOUT/POLLHUP/POLLERR与EPOLL*的值相同，Channel可以直接处理
+                channel->set_revents(pfd->revents);
+                activeChannels->push_back(channel);
+            }
+        }
+    }
+}
+
+void PollPoller::updateChannel(Channel* channel)
+{
+    LOG_INFO("func=%s => fd = %d events = %d, index=%d\n", __func__, channel->fd(), channel->events(), channel->index());
+    if (channel->index() == kNew)
+    {
+        // 新的channel：追加到pollfd数组末尾
+        struct pollfd pfd;
+        pfd.fd = channel->fd();
+        pfd.events = static_cast<short>(channel->events());
+        pfd.revents = 0;
+        pollfds_.push_back(pfd);
+        channel->set_index(static_cast<int>(pollfds_.size()) - 1);
+        channels_.insert(pfd.fd, channel);
+    }
+    else
+    {
+        // 已有的channel：直接通过index修改
+        struct pollfd& pfd = pollfds_[channel->index()];
+        pfd.fd = channel->fd();
+        pfd.events = static_cast<short>(channel->events());
+        pfd.revents = 0;
+        // 不监听任何事件：fd设置为负数，poll会忽略负数的fd（-fd-1保证fd为0时也是负数）
+        if (channel->isNoneEvent())
+        {
+            pfd.fd = -channel->fd() - 1;
+        }
+    }
+}
+
+void PollPoller::removeChannel(Channel* channel)
+{
+    LOG_INFO("func=%s, fd=%d\n", __func__, channel->fd());
+    int idx = channel->index();
+    if (idx == kNew)
+    {
+        return;
+    }
+    channels_.erase(channel->fd());
+
+    // 和最后一个元素交换后pop_back，数组保持紧凑，O(1)删除
+    if (static_cast<size_t>(idx) != pollfds_.size() - 1)
+    {
+        int lastFd = pollfds_.back().fd;
+        std::iter_swap(pollfds_.begin() + idx, pollfds_.end() - 1);
+        // 被禁用的fd是负数，还原出真正的fd
+        if (lastFd < 0)
+        {
+            lastFd = -lastFd - 1;
+        }
+        channels_.find(lastFd)->set_index(idx);
+    }
+    pollfds_.pop_back();
+    channel->set_index(kNew);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "Poller.h"
+
+#include <poll.h>
+#include <vector>
+
+
+/*
+基于poll的IO复用：
+1. 所有监听的fd保存在一个紧凑的pollfd数组中，channel的index就是它在数组中的下标，增删改都是O(1)
+2. 没有epoll的内核红黑树与就绪链表，每次poll都会把整个数组拷贝进内核，只适合fd很少的loop（定时器loop、工作loop、测试）
+*/
+class PollPoller : public Poller
+{
+public:
+    PollPoller(EventLoop* loop);
+    ~PollPoller() override = default;
+
+    Timestamp poll(int timeoutMs, ChannelList* activeChannels) override;
+    void updateChannel(Channel* channel) override;
+    void removeChannel(Channel* channel) override;
+
+private:
+    void fillActiveChannels(int numEvents, ChannelList* activeChannels) const;
+
+    using PollFdList = std::vector<struct pollfd>;
+    PollFdList pollfds_;
+};
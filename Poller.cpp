@@ -7,6 +7,5 @@ Poller::Poller(EventLoop* loop)
 
 bool Poller::hasChannel(Channel* channel) const
 {
-    auto it = channels_.find(channel->fd());
-    return it != channels_.end() && it->second == channel; 
+    return channels_.find(channel->fd()) == channel;
 }
\ No newline at end of file
@@ -2,9 +2,9 @@
 #include "noncopyable.h"
 #include "nonmoveable.h"
 #include "Timestamp.h"
+#include "ChannelTable.h"
 
 #include <vector>
-#include <unordered_map>
 #include <memory>
 
 
@@ -24,15 +24,22 @@ public:
     virtual void updateChannel(Channel* channel) = 0;
     virtual void removeChannel(Channel* channel) = 0;
 
+    // 是否支持边沿触发，不支持的poller忽略Channel::isEdgeTriggered
+    virtual bool supportsEdgeTriggered() const { return false; }
+
+    // 单次poll最多返回的事件数：初始值和上限，在这个范围内根据最近返回的事件数自动伸缩，没有事件数组的poller忽略
+    virtual void setEventBatchSize(int /*initial*/, int /*max*/) {}
+    // 当前单次poll最多返回的事件数，0表示不限制
+    virtual int eventBatchSize() const { return 0; }
+
     // 判断channel是否在channels_中
     bool hasChannel(Channel* channel) const;
 
     // 提供获取具体实现的IO复用机制
     static std::unique_ptr<Poller> newDefaultPoller(EventLoop* loop);
 protected:
-    using ChannelMap = std::unordered_map<int, Channel*>;
-    // 持有channel对象，但不对channel的生命周期进行管理
-    ChannelMap channels_;
+    // 持有channel对象，但不对channel的生命周期进行管理，按fd直接索引
+    ChannelTable channels_;
 private:
     // 线程同步的事情已经交给EventLoop了，在Poller或者Poller的派生类这一层完全不需要使用到EventLoop，这里为什么要持有EventLoop有点不理
     // 解？为了组件的一致性所以即使不需要也持有？即这个持有动作是为了表明一个IO复用机制只能绑定一个事件循环，而一个事件循环只能绑定一个线程
@@ -81,4 +81,12 @@ void Socket::setKeepAlive(bool on)
 {
     int optval = on ? 1 : 0;
     setsockopt(sockfd_, SOL_SOCKET, SO_KEEPALIVE, &optval, sizeof(optval));
+}
+
+void Socket::setBusyPoll(int usec)
+{
+    if (setsockopt(sockfd_, SOL_SOCKET, SO_BUSY_POLL, &usec, sizeof(usec)) < 0)
+    {
+        LOG_ERROR("设置SO_BUSY_POLL失败，fd=%d errno:%d\n", sockfd_, errno);
+    }
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "Channel.h"
 #include "Socket.h"
 #include "EventLoop.h"
+#include "TimingWheel.h"
+#include "IoUringPoller.h"
 
 
 static EventLoop* cehckEventLoopNotNull(EventLoop* eventLoop)
@@ -28,11 +30,25 @@ TcpConnection::TcpConnection(EventLoop* eventLoop,
     , localAddr_(localAddr)
     , peerAddr_(peerAddr)
     , highWaterMark_(64*1024*1024)      // 64M
+    // 缓冲区的存储在所属loop中第一次用到时才从loop的内存池分配
+    , bufferPool_(eventLoop_->sharedBufferPool())
+    , inputBuffer_(bufferPool_.get())
+    , outputBuffer_(bufferPool_.get())
+    , idleEntry_(nullptr)
+    , completionIo_(false)
+    , recvOp_(0)
+    , sendOp_(0)
+    , sendingBuffer_(bufferPool_.get())
+    , peerClosed_(false)
+    , edgeTriggered_(false)
+    , loadCounted_(false)
+    , reportedBufferedBytes_(0)
 {
     channel_->setReadCallback(std::bind(&TcpConnection::handleRead, this, std::placeholders::_1));
     channel_->setWriteCallback(std::bind(&TcpConnection::handleWrite, this));
     channel_->setCloseCallback(std::bind(&TcpConnection::handleClose, this));
     channel_->setErrorCallback(std::bind(&TcpConnection::handleError, this));
+    channel_->setName(name_);
 
     socket_->setKeepAlive(true);
 
@@ -83,18 +99,34 @@ void TcpConnection::sendInLoop(const char* data, size_t len)
         return;
     }
 
+    // 完成模式：数据先进入outputBuffer_，没有正在发送的操作就提交一个IORING_OP_SEND，随下一次poll批量进入内核
+    if (completionIo_)
+    {
+        size_t oldLen = outputBuffer_.readableBytes() + sendingBuffer_.readableBytes();
+        if (oldLen + len >= highWaterMark_ && oldLen < highWaterMark_ && highWaterMarkCallback_)
+        {
+            eventLoop_->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), oldLen + len));
+        }
+        outputBuffer_.append(data, len);
+        if (sendOp_ == 0)
+        {
+            flushCompletionSend();
+        }
+        updateBufferedLoad();
+        return;
+    }
+
     // 没有监听写操作，并且发送缓冲区没有数据要发送，说明这个链接是第一次发送数据，或者说上次发送数据没有数据残留在发送缓冲区
-    if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0)
+    if (!isWriting() && outputBuffer_.readableBytes() == 0)
     {
         nwrote = write(channel_->fd(), data, len);
         if (nwrote >= 0)
         {
             remaining = len - nwrote;
             // 数据发完并且存在回调：发送数据后进行一些操作
-            if (remaining == 0 && writeCompleteCallback_)
+            if (remaining == 0)
             {
-                // 这里的writeCompleteCallback_中有可能会调用send导致无限递归，所以必须使用queueInLoop
-                eventLoop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+                notifyWriteComplete();
             }
         }
         else
@@ -150,6 +182,7 @@ void TcpConnection::sendInLoop(const char* data, size_t len)
         {
             channel_->enableWriting();
         }
+        updateBufferedLoad();
     }
 }
 
@@ -164,16 +197,107 @@ void TcpConnection::shutdown()
     }
 }
 
+void TcpConnection::forceClose()
+{
+    if (state_ == StateE::kConnected || state_ == StateE::kDisconnecting)
+    {
+        // 总是排队执行：调用方可能正在遍历链接表，handleClose会通过closeCallback_修改它
+        eventLoop_->queueInLoop(std::bind(&TcpConnection::forceCloseInLoop, shared_from_this()));
+    }
+}
+
+void TcpConnection::forceCloseInLoop()
+{
+    if (state_ == StateE::kConnected || state_ == StateE::kDisconnecting)
+    {
+        handleClose();
+    }
+}
+
+void TcpConnection::setIdleTimeout(double seconds)
+{
+    // 绑定shared_from_this：跨线程设置时保证执行时链接还活着
+    eventLoop_->runInLoop(std::bind(&TcpConnection::setIdleTimeoutInLoop, shared_from_this(), seconds));
+}
+
+void TcpConnection::setIdleTimeoutInLoop(double seconds)
+{
+    clearIdleTimeout();
+    if (seconds > 0 && state_ != StateE::kDisconnected)
+    {
+        // 时间轮回调只持有弱引用，不延长链接的生命周期
+        std::weak_ptr<TcpConnection> weakConn(shared_from_this());
+        idleEntry_ = eventLoop_->timingWheel()->add(seconds, [weakConn]() {
+            TcpConnectionPtr conn = weakConn.lock();
+            if (conn)
+            {
+                conn->handleIdleTimeout();
+            }
+        });
+    }
+}
+
+void TcpConnection::touchIdle()
+{
+    if (idleEntry_)
+    {
+        eventLoop_->timingWheel()->touch(idleEntry_);
+    }
+}
+
+void TcpConnection::clearIdleTimeout()
+{
+    if (idleEntry_)
+    {
+        eventLoop_->timingWheel()->remove(idleEntry_);
+        idleEntry_ = nullptr;
+    }
+}
+
+// 时间轮 => 空闲超时：和对端close一样走handleClose，由TcpServer移除链接
+void TcpConnection::handleIdleTimeout()
+{
+    clearIdleTimeout();
+    if (state_ == StateE::kConnected || state_ == StateE::kDisconnecting)
+    {
+        LOG_INFO("TcpConnection::handleIdleTimeout 链接空闲超时，关闭链接 %s fd=%d\n", name_.c_str(), channel_->fd());
+        handleClose();
+    }
+}
+
 // 给上层提供如TcpServer
 // 链接建立：在TcpServer创建TcpConnection时调用
 void TcpConnection::connectEstablished()
 {
     setState(StateE::kConnected);
+    loadCounted_ = true;
+    eventLoop_->addConnectionCount(1);
     // 对于底层组件（channel），传递智能指针，channel层通过弱智能指针接收，仅在调用时提升，避免TcpConnection生命周期扩大
     // 也避免上层（应用层）意外将TcpConnection手动释放后，channel依旧访问被释放的对象的问题
     channel_->tie(shared_from_this());
-    // 注册到epoll
-    channel_->enableReading();
+    // 所属loop开启了忙轮询
+    if (eventLoop_->socketBusyPollUs() > 0)
+    {
+        socket_->setBusyPoll(eventLoop_->socketBusyPollUs());
+    }
+    if (completionIo_)
+    {
+        startCompletionIo();
+    }
+    else if (edgeTriggered_ && eventLoop_->supportsEdgeTriggered())
+    {
+        // 边沿触发：读写一次注册，之后发送数据不再修改监听事件
+        channel_->setEdgeTriggered(true);
+        channel_->enableReading();
+        channel_->enableWriting();
+    }
+    else
+    {
+        // 所属loop的poller不支持边沿触发，退回水平触发
+        edgeTriggered_ = false;
+        // 注册到epoll
+        channel_->enableReading();
+    }
     // 回调：链接创建前的一些操作，在TcpServer创建TcpConnection时设置
     connectionCallback_(shared_from_this());
 }
@@ -183,14 +307,40 @@ void TcpConnection::connectEstablished()
 void TcpConnection::connectDestroyed()
 {
     // 通过tcp的状态来避免重复销毁
-    if (state_ == StateE::kConnected)
+    const bool connected = state_ == StateE::kConnected;
+    // shutdown之后（kDisconnecting）被TcpServer直接销毁的链接同样要下树
+    if (connected || state_ == StateE::kDisconnecting)
     {
         setState(StateE::kDisconnected);
         // 从epoll下树
-        channel_->disableAll();
+        if (completionIo_)
+        {
+            stopCompletionIo();
+        }
+        else
+        {
+            channel_->disableAll();
+        }
+    }
+    // 等待中的协程持有链接：不管之前是什么状态，都要让它们看到链接断开，否则协程帧和链接永远不会释放
+    wakeWaiters();
+    if (connected)
+    {
         // 回调：销毁前的一些操作，在TcpServer创建TcpConnection时设置
         connectionCallback_(shared_from_this());
     }
+    clearIdleTimeout();
+    // 链接已经关闭，剩下的数据没有用了：在loop线程中把存储还给内存池，链接可能在其他线程析构
+    // 完成模式下sendingBuffer_可能还在被内核读取，等链接析构时再释放
+    inputBuffer_.retrieveAll();
+    outputBuffer_.retrieveAll();
+    if (loadCounted_)
+    {
+        loadCounted_ = false;
+        eventLoop_->addConnectionCount(-1);
+        eventLoop_->addBufferedBytes(-reportedBufferedBytes_);
+        reportedBufferedBytes_ = 0;
+    }
     // 从poller的map上删除
     channel_->remove();
 }
@@ -199,12 +349,24 @@ void TcpConnection::connectDestroyed()
 // poller => channel::readCallback => TcpConnection::handleRead
 void TcpConnection::handleRead(Timestamp reveiveTime)
 {
+    if (completionIo_)
+    {
+        handleReadCompletion(reveiveTime);
+        return;
+    }
+    if (edgeTriggered_)
+    {
+        handleReadEdge(reveiveTime);
+        return;
+    }
     int savedErrno = 0;
     ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
     if (n > 0)
     {
-        // （TcpConnection由TcpServer的shared_ptr管理）对于上层组件：这里如果传递this指针会导致TcpConnection的生命周期不明确，而使用shared_from_this传递，可以明确的表示TcpConnection由一个shared_ptr管理
-        messageCallback_(shared_from_this(), &inputBuffer_, reveiveTime);
+        touchIdle();
+        deliverMessage(reveiveTime);
+        // 业务层没有取走的数据还留在inputBuffer_中
+        updateBufferedLoad();
     }
     else if (n == 0)
     {
@@ -218,10 +380,70 @@ void TcpConnection::handleRead(Timestamp reveiveTime)
     }
 }
 
+// 有协程在等待数据时直接在这里恢复它，没有协程等待时交给messageCallback_，都没有时数据留在inputBuffer_中
+void TcpConnection::deliverMessage(Timestamp receiveTime)
+{
+    if (readWaiter_)
+    {
+        resumeWaiter(readWaiter_);
+        return;
+    }
+    if (messageCallback_)
+    {
+        // （TcpConnection由TcpServer的shared_ptr管理）对于上层组件：这里如果传递this指针会导致TcpConnection的生命周期不明确，而使用shared_from_this传递，可以明确的表示TcpConnection由一个shared_ptr管理
+        messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+    }
+}
+
+// 发送缓冲区的数据全部交给内核之后调用
+void TcpConnection::notifyWriteComplete()
+{
+    if (writeCompleteCallback_)
+    {
+        // 这里的writeCompleteCallback_中有可能会调用send导致无限递归，所以必须使用queueInLoop
+        // 网络回调层可以包含业务逻辑，但是业务逻辑不应该阻塞网络层，所以不能直接在IOLoop中直接调用回调
+        eventLoop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+    }
+    // 协程在co_await drain()时发送缓冲区一定不为空，这里不会和它自己的send重入
+    if (drainWaiter_)
+    {
+        resumeWaiter(drainWaiter_);
+    }
+}
+
+// 链接断开：等待中的协程都要恢复，读到nullptr/nullopt、drain得到false
+void TcpConnection::wakeWaiters()
+{
+    if (readWaiter_)
+    {
+        resumeWaiter(readWaiter_);
+    }
+    if (drainWaiter_)
+    {
+        resumeWaiter(drainWaiter_);
+    }
+}
+
+// 先移出来再调用：恢复的协程可能马上co_await下一次读写，重新设置等待者；条件还没满足并且没有新的等待者时放回去继续等
+void TcpConnection::resumeWaiter(Waiter& slot)
+{
+    Waiter waiter(std::move(slot));
+    if (!waiter() && !slot)
+    {
+        slot = std::move(waiter);
+    }
+}
+
+bool TcpConnection::outputDrained() const
+{
+    return !isWriting() && outputBuffer_.readableBytes() == 0 && sendingBuffer_.readableBytes() == 0;
+}
+
 void TcpConnection::shutdownInLoop()
 {
     // 如果channel还在监听写，说明还有数据要发送，就不关闭，写完再关闭
-    if (!channel_->isWriting())
+    // 完成模式：一次发送完成到提交下一个块之间sendOp_为0，还要看两个缓冲区是否发完，发完后由handleWriteCompletion关闭
+    if (completionIo_ ? outputDrained() : !isWriting())
     {
         // 关闭写端
         socket_->shutdownWrite();
@@ -232,24 +454,32 @@ void TcpConnection::shutdownInLoop()
 // poller => channel::writeCallback => TcpConnection::handleWrite
 void TcpConnection::handleWrite()
 {
+    if (completionIo_)
+    {
+        handleWriteCompletion();
+        return;
+    }
+    if (edgeTriggered_)
+    {
+        handleWriteEdge();
+        return;
+    }
     if (channel_->isWriting())
     {
         int savedErrno = 0;
         ssize_t n = outputBuffer_.writeFd(channel_->fd(), &savedErrno);
         if (n > 0)
         {
+            touchIdle();
             outputBuffer_.retrieve(n);
+            updateBufferedLoad();
             // 发送缓冲区中所有数据都发完了
             if (outputBuffer_.readableBytes() == 0)
             {
                 // 让epoll停止监听写，因为没有数据要发送了
                 channel_->disableWriting();
                 // 写完后的回调操作，如果有就执行
-                if (writeCompleteCallback_)
-                {
-                    // 这里没有重入风险但是为什么要通过queueInLoop调用？->网络回调层可以包含业务逻辑，但是业务逻辑不应该阻塞网络层，所以不能直接在IOLoop中直接调用回调
-                    eventLoop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
-                }
+                notifyWriteComplete();
                 if (state_ == StateE::kDisconnecting)
                 {
                     shutdownInLoop();
@@ -275,9 +505,18 @@ void TcpConnection::handleClose()
     // 设置Tcp状态为关闭
     setState(StateE::kDisconnected);
     // 将该channel从epoll树上删除，channle还在poller的map上
-    channel_->disableAll();
+    if (completionIo_)
+    {
+        stopCompletionIo();
+    }
+    else
+    {
+        channel_->disableAll();
+    }
 
     TcpConnectionPtr connPtr(shared_from_this());
+    // 等待中的协程也持有链接，先让它们看到链接断开
+    wakeWaiters();
     // 回调：销毁前的一些操作，在TcpServer创建TcpConnection时设置，不需要在queueInLoop中调用：即使connectionCallback_->send->sendInLoop.....没有无限递归
     connectionCallback_(connPtr);
     // 回调：关闭tcp链接，TcpServer创建TcpConnection时设置，会绑定TcpConnection::connectDestroyed，同上
@@ -300,4 +539,242 @@ void TcpConnection::handleError()
         err = optval;
     }
     LOG_ERROR("TcpConnection::handleError name:%s - SO_ERROR:%d\n", name_.c_str(), err);
+}
+
+void TcpConnection::updateBufferedLoad()
+{
+    if (!loadCounted_)
+    {
+        return;
+    }
+    int64_t buffered = static_cast<int64_t>(inputBuffer_.readableBytes() + outputBuffer_.readableBytes() + sendingBuffer_.readableBytes());
+    // 没有变化时不写共享的原子变量
+    if (buffered != reportedBufferedBytes_)
+    {
+        eventLoop_->addBufferedBytes(buffered - reportedBufferedBytes_);
+        reportedBufferedBytes_ = buffered;
+    }
+}
+
+bool TcpConnection::isWriting() const
+{
+    if (completionIo_)
+    {
+        return sendOp_ != 0;
+    }
+    // 边沿触发时EPOLLOUT一直在监听，只能通过发送缓冲区判断
+    return edgeTriggered_ ? outputBuffer_.readableBytes() > 0 : channel_->isWriting();
+}
+
+void TcpConnection::startCompletionIo()
+{
+    IoUringPoller* ring = eventLoop_->ioUringPoller();
+    // 所属loop不是io_uring后端，退回就绪通知模式
+    if (ring == nullptr)
+    {
+        completionIo_ = false;
+        channel_->enableReading();
+        return;
+    }
+    // 操作的回调持有链接：内核确认操作结束之前链接（包括正在发送的sendingBuffer_）不能被析构
+    TcpConnectionPtr self(shared_from_this());
+    recvOp_ = ring->submitRecv(channel_->fd(), channel_.get(), [self](int res, const char* data) {
+        return self->onRecvComplete(res, data);
+    });
+}
+
+void TcpConnection::stopCompletionIo()
+{
+    IoUringPoller* ring = eventLoop_->ioUringPoller();
+    if (recvOp_ != 0)
+    {
+        ring->cancelCompletion(recvOp_);
+        recvOp_ = 0;
+    }
+    if (sendOp_ != 0)
+    {
+        ring->cancelCompletion(sendOp_);
+        sendOp_ = 0;
+    }
+}
+
+int TcpConnection::onRecvComplete(int res, const char* data)
+{
+    if (res > 0)
+    {
+        inputBuffer_.append(data, res);
+    }
+    else
+    {
+        // 0：对端关闭；<0：接收出错，内核已经结束这个recv操作，都按关闭处理
+        if (res < 0)
+        {
+            LOG_ERROR("TcpConnection::onRecvComplete发生错误 %s errno:%d\n", name_.c_str(), -res);
+        }
+        peerClosed_ = true;
+        recvOp_ = 0;
+    }
+    return EPOLLIN;
+}
+
+int TcpConnection::onSendComplete(int res)
+{
+    sendOp_ = 0;
+    if (res > 0)
+    {
+        sendingBuffer_.retrieve(res);
+    }
+    else if (res < 0 && res != -EAGAIN && res != -EINTR)
+    {
+        LOG_ERROR("TcpConnection::onSendComplete发生错误 %s errno:%d\n", name_.c_str(), -res);
+        // 对端已经关闭，丢弃剩余的数据，等待recv上报关闭
+        if (res == -EPIPE || res == -ECONNRESET)
+        {
+            sendingBuffer_.retrieveAll();
+            outputBuffer_.retrieveAll();
+        }
+    }
+    return EPOLLOUT;
+}
+
+void TcpConnection::flushCompletionSend()
+{
+    // 上一次没发完的数据优先发送，发完了再把新追加的数据换过来
+    if (sendingBuffer_.readableBytes() == 0)
+    {
+        sendingBuffer_.swap(outputBuffer_);
+    }
+    if (sendingBuffer_.readableBytes() == 0)
+    {
+        return;
+    }
+    TcpConnectionPtr self(shared_from_this());
+    // 每次提交一个块，发送完成后handleWriteCompletion继续提交下一个
+    sendOp_ = eventLoop_->ioUringPoller()->submitSend(channel_->fd(), channel_.get(),
+                                                      sendingBuffer_.peek(), sendingBuffer_.contiguousBytes(),
+                                                      [self](int res, const char*) {
+        return self->onSendComplete(res);
+    });
+}
+
+// 完成模式：数据已经在onRecvComplete中放入inputBuffer_
+void TcpConnection::handleReadCompletion(Timestamp receiveTime)
+{
+    if (inputBuffer_.readableBytes() > 0 && state_ != StateE::kDisconnected)
+    {
+        touchIdle();
+        deliverMessage(receiveTime);
+    }
+    updateBufferedLoad();
+    if (peerClosed_ && state_ != StateE::kDisconnected)
+    {
+        handleClose();
+    }
+}
+
+// 完成模式：一次发送完成，继续发送剩余数据或者通知发送完毕
+void TcpConnection::handleWriteCompletion()
+{
+    if (state_ == StateE::kDisconnected || sendOp_ != 0)
+    {
+        return;
+    }
+    touchIdle();
+    updateBufferedLoad();
+    if (sendingBuffer_.readableBytes() > 0 || outputBuffer_.readableBytes() > 0)
+    {
+        flushCompletionSend();
+    }
+    else
+    {
+        notifyWriteComplete();
+        if (state_ == StateE::kDisconnecting)
+        {
+            shutdownInLoop();
+        }
+    }
+}
+
+// 边沿触发：这次通知之后内核不会再提醒已经到达的数据，必须一直读到EAGAIN，全部读完后再交给业务层一次
+void TcpConnection::handleReadEdge(Timestamp receiveTime)
+{
+    bool peerClosed = false;
+    int savedErrno = 0;
+    size_t oldLen = inputBuffer_.readableBytes();
+    while (true)
+    {
+        ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
+        if (n > 0)
+        {
+            continue;
+        }
+        if (n == 0)
+        {
+            peerClosed = true;
+        }
+        else if (savedErrno == EINTR)
+        {
+            continue;
+        }
+        break;
+    }
+
+    if (inputBuffer_.readableBytes() > oldLen)
+    {
+        touchIdle();
+        deliverMessage(receiveTime);
+        updateBufferedLoad();
+    }
+    // messageCallback_中可能已经关闭了链接
+    if (state_ == StateE::kDisconnected)
+    {
+        return;
+    }
+    if (peerClosed)
+    {
+        handleClose();
+    }
+    else if (savedErrno != EAGAIN && savedErrno != EWOULDBLOCK)
+    {
+        errno = savedErrno;
+        LOG_ERROR("TcpConnection::handleReadEdge发生错误，errno:%d\n", savedErrno);
+        handleError();
+    }
+}
+
+// 边沿触发：EPOLLOUT一直在监听，发送缓冲区为空时的可写通知直接忽略，有数据就写到EAGAIN为止
+void TcpConnection::handleWriteEdge()
+{
+    if (outputBuffer_.readableBytes() == 0 || state_ == StateE::kDisconnected)
+    {
+        return;
+    }
+    int savedErrno = 0;
+    while (outputBuffer_.readableBytes() > 0)
+    {
+        ssize_t n = outputBuffer_.writeFd(channel_->fd(), &savedErrno);
+        if (n > 0)
+        {
+            outputBuffer_.retrieve(n);
+        }
+        else if (savedErrno != EINTR)
+        {
+            break;
+        }
+    }
+    touchIdle();
+    updateBufferedLoad();
+
+    if (outputBuffer_.readableBytes() == 0)
+    {
+        notifyWriteComplete();
+        if (state_ == StateE::kDisconnecting)
+        {
+            shutdownInLoop();
+        }
+    }
+    else if (savedErrno != EAGAIN && savedErrno != EWOULDBLOCK)
+    {
+        LOG_ERROR("TcpConnection::handleWriteEdge失败errno：%d\n", savedErrno);
+    }
 }
\ No newline at end of file
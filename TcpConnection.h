@@ -4,9 +4,13 @@
 #include "Callbacks.h"
 #include "InetAddress.h"
 #include "Buffer.h"
+#include "ChainBuffer.h"
+#include "TimingWheel.h"
 
 #include <atomic>
 #include <string>
+#include <optional>
+#include <algorithm>            // search、min
 
 class EventLoop;
 class Socket;
@@ -33,6 +37,14 @@ public:
     void send(const std::string& buf);
     // 半关闭：关闭写端
     void shutdown();
+    // 强制关闭：不等发送缓冲区的数据发完，直接走handleClose，线程安全
+    void forceClose();
+    // 空闲超时：seconds秒内没有读写就关闭链接，<=0表示取消，线程安全
+    void setIdleTimeout(double seconds);
+    // 完成模式：所属loop使用io_uring后端时由内核直接收发数据，必须在connectEstablished之前设置，其他后端忽略
+    void setCompletionIo(bool on) { completionIo_ = on; }
+    // 边沿触发：读到EAGAIN为止，EPOLLOUT一直监听不再反复epoll_ctl，必须在connectEstablished之前设置，poller不支持时忽略
+    void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
 
     void setConnectionCallback(const ConnectionCallback& cb) { connectionCallback_ = cb; }
     void setMessageCallback(const MessageCallback& cb) { messageCallback_ = cb; }
@@ -40,6 +52,21 @@ public:
     void setHighWaterMarkCallback(const HighWaterMarkCallback& cb) { highWaterMarkCallback_ = cb; }
     void setCloseCallback(const CloseCallback& cb) { closeCallback_ = cb; }
 
+    class ReadAwaiter;
+    class ReadUntilAwaiter;
+    class DrainAwaiter;
+    /*
+    协程接口（C++20，协程类型见Coroutine.h），只能在所属loop线程运行的协程中co_await：
+    co_await readAtLeast(n)：输入缓冲区至少有n字节时返回&inputBuffer_，数据不够链接就断开了返回nullptr
+    co_await readUntil("\r\n")：返回分隔符之前的内容，连同分隔符从缓冲区取走，数据不够链接就断开了返回nullopt
+    co_await drain()：发送缓冲区的数据全部交给内核后返回true，链接断开返回false
+    等待的协程在handleRead/handleWrite中直接恢复，不经过queueInLoop；有协程在等待数据时不调用messageCallback_
+    每个链接同一时刻最多有一个协程在读、一个协程在drain
+    */
+    ReadAwaiter readAtLeast(size_t n);
+    ReadUntilAwaiter readUntil(std::string delimiter);
+    DrainAwaiter drain();
+
     // 链接建立-在服务端accept后
     void connectEstablished();
     // 
@@ -49,6 +76,14 @@ private:
     enum class StateE : uint8_t { kDisconnected, kConnecting, kConnected, kDisconnecting };
     void setState(StateE state) { state_ = state; }
 
+    // 协程的等待者：条件满足时恢复协程并返回true，还没满足返回false
+    using Waiter = InplaceFunction<bool()>;
+    void deliverMessage(Timestamp receiveTime);
+    void notifyWriteComplete();
+    void wakeWaiters();
+    static void resumeWaiter(Waiter& slot);
+    bool outputDrained() const;
+
     void handleRead(Timestamp );
     void handleWrite();
     void handleClose();
@@ -56,6 +91,30 @@ private:
 
     void sendInLoop(const char* message, size_t len);
     void shutdownInLoop();
+    void forceCloseInLoop();
+    void setIdleTimeoutInLoop(double seconds);
+    void handleIdleTimeout();
+    // 每次读写都刷新空闲超时，O(1)
+    void touchIdle();
+    // 将连接从时间轮上移除
+    void clearIdleTimeout();
+
+    // 完成模式的收发
+    void startCompletionIo();
+    void stopCompletionIo();
+    // 在poll中执行：只保存结果，返回需要通过channel上报的事件，业务回调仍然在handleRead/handleWrite中执行
+    int onRecvComplete(int res, const char* data);
+    int onSendComplete(int res);
+    void flushCompletionSend();
+    void handleReadCompletion(Timestamp receiveTime);
+    void handleWriteCompletion();
+    // 边沿触发的收发：一直读写到EAGAIN
+    void handleReadEdge(Timestamp receiveTime);
+    void handleWriteEdge();
+    // 是否还有数据在发送
+    bool isWriting() const;
+    // 把缓冲区字节数的变化同步到所属loop的负载统计
+    void updateBufferedLoad();
 
     EventLoop* eventLoop_;
     const std::string name_;
@@ -86,6 +145,156 @@ private:
     CloseCallback closeCallback_;
     size_t highWaterMark_;
 
+    // 缓冲区存储所在的内存池：在缓冲区之后析构，链接比所属loop活得久时释放存储也不会访问已经销毁的对象
+    std::shared_ptr<BufferPool> bufferPool_;
+    // 输入缓冲区交给messageCallback_解析，需要连续的数据
     Buffer inputBuffer_;
-    Buffer outputBuffer_;
-};
\ No newline at end of file
+    // 发送缓冲区只需要顺序写出，使用分段缓冲区：积压大量数据时追加不会拷贝已有的数据
+    ChainBuffer outputBuffer_;
+
+    // 挂在所属loop时间轮上的条目，没有设置空闲超时时为空
+    TimingWheel::Entry* idleEntry_;
+
+    // 完成模式：channel不注册就绪事件，只用来把完成事件交给handleEvent
+    bool completionIo_;
+    uint64_t recvOp_;
+    // 正在发送的操作，0表示没有
+    uint64_t sendOp_;
+    // 已经提交给内核正在发送的数据，发送完成前不能修改；新数据追加在outputBuffer_中
+    ChainBuffer sendingBuffer_;
+    // 完成模式下对端关闭或者接收出错
+    bool peerClosed_;
+
+    // 边沿触发模式：channel同时监听读写，是否在写由outputBuffer_是否有数据决定
+    bool edgeTriggered_;
+
+    // 是否已经计入所属loop的链接数
+    bool loadCounted_;
+    // 上一次计入所属loop的缓冲区字节数
+    int64_t reportedBufferedBytes_;
+
+    // 正在co_await读数据、drain的协程
+    Waiter readWaiter_;
+    Waiter drainWaiter_;
+};
+
+// 协程的await_suspend写成模板，这个头文件不需要C++20也能编译
+class TcpConnection::ReadAwaiter
+{
+public:
+    ReadAwaiter(TcpConnection* conn, size_t n) : conn_(conn), n_(n) {}
+
+    bool await_ready() const { return ready(); }
+    template <typename Handle>
+    void await_suspend(Handle handle)
+    {
+        conn_->readWaiter_ = [this, handle]() {
+            if (!ready())
+            {
+                return false;
+            }
+            handle.resume();
+            return true;
+        };
+    }
+    Buffer* await_resume() const
+    {
+        return conn_->inputBuffer_.readableBytes() >= n_ ? &conn_->inputBuffer_ : nullptr;
+    }
+
+private:
+    bool ready() const
+    {
+        return conn_->inputBuffer_.readableBytes() >= n_ || conn_->state_ == StateE::kDisconnected;
+    }
+
+    TcpConnection* conn_;
+    size_t n_;
+};
+
+class TcpConnection::ReadUntilAwaiter
+{
+public:
+    ReadUntilAwaiter(TcpConnection* conn, std::string delimiter)
+        : conn_(conn)
+        , delimiter_(std::move(delimiter))
+        , scanned_(0)
+        , found_(std::string::npos) {}
+
+    bool await_ready() { return ready(); }
+    template <typename Handle>
+    void await_suspend(Handle handle)
+    {
+        conn_->readWaiter_ = [this, handle]() {
+            if (!ready())
+            {
+                return false;
+            }
+            handle.resume();
+            return true;
+        };
+    }
+    std::optional<std::string> await_resume()
+    {
+        if (found_ == std::string::npos)
+        {
+            return std::nullopt;
+        }
+        Buffer& buf = conn_->inputBuffer_;
+        std::string line(buf.peek(), found_);
+        buf.retrieve(found_ + delimiter_.size());
+        return line;
+    }
+
+private:
+    bool ready()
+    {
+        const Buffer& buf = conn_->inputBuffer_;
+        const char* begin = buf.peek();
+        const char* end = begin + buf.readableBytes();
+        // 等待期间没有其他人读缓冲区，上次找过的部分不再重复查找，只回退分隔符长度减一处理跨两次到达的分隔符
+        const char* pos = std::search(begin + std::min(scanned_, buf.readableBytes()), end, delimiter_.begin(), delimiter_.end());
+        if (pos != end || delimiter_.empty())
+        {
+            found_ = pos - begin;
+            return true;
+        }
+        scanned_ = buf.readableBytes() >= delimiter_.size() ? buf.readableBytes() - delimiter_.size() + 1 : 0;
+        return conn_->state_ == StateE::kDisconnected;
+    }
+
+    TcpConnection* conn_;
+    std::string delimiter_;
+    size_t scanned_;
+    size_t found_;
+};
+
+class TcpConnection::DrainAwaiter
+{
+public:
+    explicit DrainAwaiter(TcpConnection* conn) : conn_(conn) {}
+
+    bool await_ready() const { return ready(); }
+    template <typename Handle>
+    void await_suspend(Handle handle)
+    {
+        conn_->drainWaiter_ = [this, handle]() {
+            if (!ready())
+            {
+                return false;
+            }
+            handle.resume();
+            return true;
+        };
+    }
+    bool await_resume() const { return conn_->state_ != StateE::kDisconnected && conn_->outputDrained(); }
+
+private:
+    bool ready() const { return conn_->state_ == StateE::kDisconnected || conn_->outputDrained(); }
+
+    TcpConnection* conn_;
+};
+
+inline TcpConnection::ReadAwaiter TcpConnection::readAtLeast(size_t n) { return ReadAwaiter(this, n); }
+inline TcpConnection::ReadUntilAwaiter TcpConnection::readUntil(std::string delimiter) { return ReadUntilAwaiter(this, std::move(delimiter)); }
+inline TcpConnection::DrainAwaiter TcpConnection::drain() { return DrainAwaiter(this); }
\ No newline at end of file
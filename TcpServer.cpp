@@ -3,6 +3,8 @@
 #include <functional>
 #include <string>
 #include <cstring>
+#include <future>
+#include <chrono>
 
 #include "Accept.h"
 #include "EventLoop.h"
@@ -28,6 +30,7 @@ TcpServer::TcpServer(EventLoop *eventLoop,
     : eventLoop_(eventLoop)
     , ipPort_(listenAddr.toIpPort())
     , name_(name)
+    , option_(option)
     , acceptor_(std::make_unique<Acceptor>(eventLoop_, listenAddr, option))
     , threadPool_(std::make_unique<EventLoopThreadPool>(eventLoop_, name))
     , connectionCallback_()
@@ -35,6 +38,13 @@ TcpServer::TcpServer(EventLoop *eventLoop,
     , writeCompleteCallback_()
     , started_(false)
     , nextConnId_(1)
+    , idleTimeout_(0.0)
+    , completionIo_(false)
+    , edgeTriggered_(false)
+    , acceptorPerLoop_(false)
+    , stallThresholdMs_(0)
+    , stopping_(false)
+    , drainingMaps_(0)
 {
     acceptor_->setNewConnectionCallback(std::bind(&TcpServer::newConnection, this, std::placeholders::_1, std::placeholders::_2));
 }
@@ -58,7 +68,48 @@ TcpServer::~TcpServer()
         为什么不直接erase？为了遍历安全，erase会导致迭代器失效，每次需要手动保存迭代器，而且多次erase可能导致rehash
         */
     }
-    
+
+    // 每个loop的监听器和链接只能在自己的loop中销毁；必须等待完成：之后threadPool_析构会退出这些loop，来不及执行的任务会丢失
+    for (const std::shared_ptr<LoopAcceptor>& la : loopAcceptors_)
+    {
+        // loop线程和等待的线程谁先抢到claimed谁清理，只清理一次
+        auto claimed = std::make_shared<std::atomic_bool>(false);
+        auto cleanup = [la, claimed]() {
+            if (claimed->exchange(true))
+            {
+                return;
+            }
+            for (auto& item : la->connections)
+            {
+                item.second->connectDestroyed();
+            }
+            la->connections.clear();
+            la->acceptor.reset();
+        };
+        // loop还没开始或者已经退出（例如baseLoop的loop()已经返回）：投递的任务不会被执行，直接在当前线程清理
+        if (la->loop->isInLoopThread() || !la->loop->looping())
+        {
+            cleanup();
+            continue;
+        }
+        // 任务持有promise：loop没来得及执行就析构时任务随队列销毁，promise析构，等待也会返回
+        auto done = std::make_shared<std::promise<void>>();
+        std::future<void> finished = done->get_future();
+        la->loop->runInLoop([cleanup, done]() {
+            cleanup();
+            done->set_value();
+        });
+        done.reset();
+        // 等待期间loop退出（还没析构）时任务留在队列里不会被执行，由当前线程清理
+        while (finished.wait_for(std::chrono::milliseconds(10)) != std::future_status::ready)
+        {
+            if (!la->loop->looping())
+            {
+                cleanup();
+                break;
+            }
+        }
+    }
 }
 
 void TcpServer::setThreadNum(int numThreads)
@@ -66,27 +117,186 @@ void TcpServer::setThreadNum(int numThreads)
     threadPool_->setThreadNum(numThreads);
 }
 
+void TcpServer::setDispatchPolicy(EventLoopThreadPool::DispatchPolicy policy)
+{
+    threadPool_->setDispatchPolicy(policy);
+}
+
+void TcpServer::setCpuAffinity(std::vector<int> cpus)
+{
+    threadPool_->setCpuAffinity(std::move(cpus));
+}
+
 void TcpServer::start()
 {
     // 防御性编程：防止一个TcpServer被start多次
     if (started_++ == 0)
     {
         threadPool_->start(threadInitCallback_);
-        eventLoop_->runInLoop(std::bind(&Acceptor::listenFd, acceptor_.get()));
+        if (stallThresholdMs_ > 0)
+        {
+            watchdog_ = std::make_unique<LoopWatchdog>(stallThresholdMs_);
+            watchdog_->watch(eventLoop_);
+            for (EventLoop* loop : threadPool_->getAllLoops())
+            {
+                // 没有子线程时getAllLoops返回的就是baseLoop
+                if (loop != eventLoop_)
+                {
+                    watchdog_->watch(loop);
+                }
+            }
+            watchdog_->start();
+        }
+        if (acceptorPerLoop_ && option_ == kReusePort)
+        {
+            startAcceptorPerLoop();
+        }
+        else
+        {
+            if (acceptorPerLoop_)
+            {
+                LOG_ERROR("TcpServer::start [%s] 每个loop一个监听器需要kReusePort，退回baseLoop监听\n", name_.c_str());
+            }
+            eventLoop_->runInLoop(std::bind(&Acceptor::listenFd, acceptor_.get()));
+        }
     }
 }
 
-void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr)
+void TcpServer::stop(double drainSeconds, StopCallback done)
 {
-    // 获取subLoop
-    EventLoop* ioLoop = threadPool_->getNextLoop();
-    char buf[64] = {0};
-    snprintf(buf, sizeof(buf), "-%s#%d", ipPort_.c_str(), nextConnId_);
-    ++nextConnId_;
-    std::string connName = name_ + buf;
+    eventLoop_->runInLoop([this, drainSeconds, done = std::move(done)]() mutable {
+        stopInLoop(drainSeconds, std::move(done));
+    });
+}
 
-    LOG_INFO("TcpServer::newConnection [%s] - 新链接[%s] from %s \n", name_.c_str(), ipPort_.c_str(),peerAddr.toIpPort().c_str());
+void TcpServer::stopInLoop(double drainSeconds, StopCallback done)
+{
+    if (stopping_)
+    {
+        LOG_ERROR("TcpServer::stop [%s] 已经在停止中，忽略这次调用\n", name_.c_str());
+        return;
+    }
+    stopping_ = true;
+    stopCallback_ = std::move(done);
+    if (started_ == 0)
+    {
+        finishStop();
+        return;
+    }
+    LOG_INFO("TcpServer::stop [%s] 停止接受新链接，排空%lu个链接，最多等待%.1f秒\n", name_.c_str(), connectionMap_.size(), drainSeconds);
+
+    // 关闭监听socket：还在全连接队列里没有accept的链接会被内核重置
+    acceptor_.reset();
+    drainingMaps_ = 1 + loopAcceptors_.size();
+    // 先启动超时定时器：没有线程池时每个loop的排空就在当前线程同步执行，可能马上结束停止流程
+    drainTimer_ = eventLoop_->runAfter(drainSeconds, std::bind(&TcpServer::forceCloseConnections, this));
+
+    for (const std::shared_ptr<LoopAcceptor>& la : loopAcceptors_)
+    {
+        la->loop->runInLoop([this, la]() {
+            la->acceptor.reset();
+            la->draining = true;
+            for (auto& item : la->connections)
+            {
+                item.second->shutdown();
+            }
+            if (la->connections.empty())
+            {
+                eventLoop_->runInLoop(std::bind(&TcpServer::connectionsDrained, this));
+            }
+        });
+    }
+
+    for (auto& item : connectionMap_)
+    {
+        TcpConnectionPtr conn(item.second);
+        // 到链接所在的loop执行：排在connectEstablished之后，还没建立的链接也能被shutdown
+        conn->getLoop()->runInLoop([conn]() { conn->shutdown(); });
+    }
+    if (connectionMap_.empty())
+    {
+        connectionsDrained();
+    }
+}
+
+void TcpServer::connectionsDrained()
+{
+    if (--drainingMaps_ == 0)
+    {
+        eventLoop_->cancel(drainTimer_);
+        finishStop();
+    }
+}
+
+// 排空超时：对端一直不关闭或者数据一直发不出去
+void TcpServer::forceCloseConnections()
+{
+    LOG_INFO("TcpServer::stop [%s] 排空超时，强制关闭剩余的链接\n", name_.c_str());
+    for (auto& item : connectionMap_)
+    {
+        item.second->forceClose();
+    }
+    for (const std::shared_ptr<LoopAcceptor>& la : loopAcceptors_)
+    {
+        la->loop->runInLoop([la]() {
+            for (auto& item : la->connections)
+            {
+                item.second->forceClose();
+            }
+        });
+    }
+}
+
+void TcpServer::finishStop()
+{
+    // 先停止检查再退出loop
+    watchdog_.reset();
+    // 每个loop的监听器已经在自己的loop中销毁，链接表都是空的；还没执行完的强制关闭任务各自持有一份
+    loopAcceptors_.clear();
+    threadPool_->stop();
+    LOG_INFO("TcpServer::stop [%s] 所有链接已经关闭\n", name_.c_str());
+    if (stopCallback_)
+    {
+        StopCallback cb;
+        cb.swap(stopCallback_);
+        cb();
+    }
+}
 
+void TcpServer::startAcceptorPerLoop()
+{
+    // 监听端口为0时使用acceptor_已经分配到的端口，所有loop绑定同一个地址；acceptor_只绑定不监听，内核不会把链接分给它
+    InetAddress listenAddr(acceptor_->listenAddress());
+    std::vector<EventLoop*> loops = threadPool_->getAllLoops();
+    std::vector<std::future<void>> listening;
+    for (size_t i = 0; i < loops.size(); ++i)
+    {
+        auto loopAcceptor = std::make_shared<LoopAcceptor>();
+        LoopAcceptor* la = loopAcceptor.get();
+        la->loop = loops[i];
+        la->index = static_cast<int>(i);
+        la->nextConnId = 1;
+        la->draining = false;
+        // 构造只创建socket并绑定地址，注册到poller的listenFd在所属loop中执行
+        la->acceptor = std::make_unique<Acceptor>(la->loop, listenAddr, true);
+        la->acceptor->setNewConnectionCallback(std::bind(&TcpServer::newLoopConnection, this, la, std::placeholders::_1, std::placeholders::_2));
+        loopAcceptors_.push_back(std::move(loopAcceptor));
+        auto promise = std::make_shared<std::promise<void>>();
+        listening.push_back(promise->get_future());
+        la->loop->runInLoop([la, promise]() {
+            la->acceptor->listenFd();
+            promise->set_value();
+        });
+    }
+    // start返回时所有loop都已经开始监听，和baseLoop监听时一样
+    for (auto& f : listening)
+    {
+        f.wait();
+    }
+}
+
+TcpConnectionPtr TcpServer::createConnection(EventLoop* ioLoop, const std::string& connName, int sockfd, const InetAddress& peerAddr)
+{
     sockaddr_in local;
     memset(&local, 0x00, sizeof(local));
     socklen_t addrlen = sizeof(local);
@@ -98,18 +308,67 @@ void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr)
     // 为什么要每次去获取？因为设置监听ipport的时候，可能监听多个ipport还有可能随机监听，所以ipport每次都去动态的获取
     TcpConnectionPtr conn(std::make_shared<TcpConnection>(ioLoop, connName, sockfd, localAddress, peerAddr));
 
-    connectionMap_[connName] = conn;
     // 默认什么都不做
     conn->setConnectionCallback(connectionCallback_);
     conn->setMessageCallback(messageCallback_);
     conn->setWriteCompleteCallback(writeCompleteCallback_);
 
+    conn->setCompletionIo(completionIo_);
+    conn->setEdgeTriggered(edgeTriggered_);
+    if (idleTimeout_ > 0)
+    {
+        conn->setIdleTimeout(idleTimeout_);
+    }
+    return conn;
+}
+
+void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr)
+{
+    // 获取subLoop
+    EventLoop* ioLoop = threadPool_->getNextLoop();
+    char buf[64] = {0};
+    snprintf(buf, sizeof(buf), "-%s#%d", ipPort_.c_str(), nextConnId_);
+    ++nextConnId_;
+    std::string connName = name_ + buf;
+
+    LOG_INFO("TcpServer::newConnection [%s] - 新链接[%s] from %s \n", name_.c_str(), ipPort_.c_str(),peerAddr.toIpPort().c_str());
+
+    TcpConnectionPtr conn(createConnection(ioLoop, connName, sockfd, peerAddr));
+    connectionMap_[connName] = conn;
     conn->setCloseCallback(std::bind(&TcpServer::removeConnection, this, std::placeholders::_1));
 
     ioLoop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
 
 }
 
+// 在la->loop中执行：accept出来的链接直接在当前loop中建立
+void TcpServer::newLoopConnection(LoopAcceptor* la, int sockfd, const InetAddress& peerAddr)
+{
+    char buf[64] = {0};
+    snprintf(buf, sizeof(buf), "-%s#%d-%ld", ipPort_.c_str(), la->index, la->nextConnId);
+    ++la->nextConnId;
+    std::string connName = name_ + buf;
+
+    LOG_INFO("TcpServer::newLoopConnection [%s] - loop%d新链接[%s] from %s \n", name_.c_str(), la->index, ipPort_.c_str(), peerAddr.toIpPort().c_str());
+
+    TcpConnectionPtr conn(createConnection(la->loop, connName, sockfd, peerAddr));
+    la->connections[connName] = conn;
+    conn->setCloseCallback(std::bind(&TcpServer::removeLoopConnection, this, la, std::placeholders::_1));
+    conn->connectEstablished();
+}
+
+// 在la->loop中执行：handleClose => closeCallback_，链接表就在当前loop中，不需要经过baseLoop
+void TcpServer::removeLoopConnection(LoopAcceptor* la, const TcpConnectionPtr& conn)
+{
+    LOG_INFO("TcpServer::removeLoopConnection [%s] - connnection%s\n", name_.c_str(), conn->name().c_str());
+    size_t n = la->connections.erase(conn->name());
+    la->loop->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+    if (n > 0 && la->draining && la->connections.empty())
+    {
+        eventLoop_->runInLoop(std::bind(&TcpServer::connectionsDrained, this));
+    }
+}
+
 void TcpServer::removeConnection(const TcpConnectionPtr& conn)
 {
     // 在baseLoop中执行
@@ -120,9 +379,14 @@ void TcpServer::removeConnectionInLoop(const TcpConnectionPtr& conn)
 {
     // 在baseLoop中执行
     LOG_INFO("TcpServer::removeConnectionInLoop [%s] - connnection%s\n", name_.c_str(), conn->name().c_str());
-    connectionMap_.erase(conn->name());
+    size_t n = connectionMap_.erase(conn->name());
     // 到ioLoop中执行
     EventLoop* ioLoop = conn->getLoop();
     ioLoop->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+    // 停止时最后一个链接移除之后才能退出ioLoop：connectDestroyed已经排在quit之前
+    if (n > 0 && stopping_ && connectionMap_.empty())
+    {
+        connectionsDrained();
+    }
 
 }
\ No newline at end of file
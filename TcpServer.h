@@ -2,16 +2,20 @@
 #include "noncopyable.h"
 #include "nonmoveable.h"
 #include "Callbacks.h"
+#include "InetAddress.h"
+#include "EventLoopThreadPool.h"
+#include "LoopWatchdog.h"
+#include "TimerId.h"
 
 #include <functional>
 #include <string>
 #include <memory>
 #include <atomic>
+#include <vector>
+#include <unordered_map>
 
 class EventLoop;
-class InetAddress;
 class Acceptor;
-class EventLoopThreadPool;
 
 
 class TcpServer : private noncopyable, private nonmoveable
@@ -19,6 +23,7 @@ class TcpServer : private noncopyable, private nonmoveable
 public:
     // 线程初始化回调函数类型
     using ThreadInitCallback = std::function<void(EventLoop*)>;
+    using StopCallback = std::function<void()>;
 
     enum Option
     {
@@ -37,17 +42,66 @@ public:
     void setWriteCompleteCallback(const WriteCompleteCallback& cb) { writeCompleteCallback_ = cb; }
 
     void setThreadNum(int numThreads);
+    // 新链接分配到哪个loop，默认轮询
+    void setDispatchPolicy(EventLoopThreadPool::DispatchPolicy policy);
+    // IO线程绑核，见EventLoopThreadPool::setCpuAffinity
+    void setCpuAffinity(std::vector<int> cpus);
+    // 新链接的空闲超时，单位秒，<=0表示不超时
+    void setIdleTimeout(double seconds) { idleTimeout_ = seconds; }
+    // 新链接使用io_uring完成模式收发，需要通过MUDUO_USE_IOURING选择io_uring后端，否则不生效
+    void setCompletionIo(bool on) { completionIo_ = on; }
+    // 新链接使用边沿触发收发，只有epoll后端生效
+    void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+    /*
+    每个loop一个监听器：线程池中的每个loop各自持有一个绑定同一地址的SO_REUSEPORT监听socket，由内核把新链接分散到各个loop，
+    accept和TcpConnection的创建都在这个loop中完成，不再经过baseLoop转发，也不需要跨线程唤醒
+    链接表也按loop分开，只在所属loop中访问；需要Option为kReusePort，必须在start之前设置
+    */
+    void setAcceptorPerLoop(bool on) { acceptorPerLoop_ = on; }
+    // 卡顿检测：baseLoop和所有IO loop中单个回调执行超过thresholdMs毫秒时报告，<=0关闭；必须在start之前设置
+    void setStallThreshold(int thresholdMs) { stallThresholdMs_ = thresholdMs; }
 
     void start();
+    /*
+    优雅停止，线程安全，只有第一次调用生效：
+    1. 关闭监听socket，不再接受新链接，SO_REUSEPORT时由新进程的监听socket接手
+    2. 每个链接shutdown：发送缓冲区的数据发完后关闭写端，等待对端关闭
+    3. drainSeconds秒后还没有关闭的链接强制关闭
+    4. 所有链接关闭后退出线程池中的IO loop，然后在baseLoop中调用done（一般是baseLoop->quit()）
+    */
+    void stop(double drainSeconds = 5.0, StopCallback done = StopCallback());
 private:
     void newConnection(int sockfd, const InetAddress& peerAddr);
     void removeConnection(const TcpConnectionPtr& conn);
     void removeConnectionInLoop(const TcpConnectionPtr& conn);
+    void stopInLoop(double drainSeconds, StopCallback done);
+    // 一个链接表已经清空，全部清空后结束停止流程，在baseLoop中执行
+    void connectionsDrained();
+    void forceCloseConnections();
+    void finishStop();
     using ConnectionMap = std::unordered_map<std::string, TcpConnectionPtr>;
 
+    // 每个loop独立的监听器与链接表，只在对应的loop线程中访问
+    struct LoopAcceptor
+    {
+        EventLoop* loop;
+        int index;
+        std::unique_ptr<Acceptor> acceptor;
+        ConnectionMap connections;
+        int64_t nextConnId;
+        // 已经开始排空：链接表清空时通知baseLoop
+        bool draining;
+    };
+    void startAcceptorPerLoop();
+    void newLoopConnection(LoopAcceptor* loopAcceptor, int sockfd, const InetAddress& peerAddr);
+    void removeLoopConnection(LoopAcceptor* loopAcceptor, const TcpConnectionPtr& conn);
+    // 创建链接并设置用户回调与选项，两种模式共用
+    TcpConnectionPtr createConnection(EventLoop* ioLoop, const std::string& connName, int sockfd, const InetAddress& peerAddr);
+
     EventLoop* eventLoop_;
     const std::string ipPort_;
     const std::string name_;
+    const Option option_;
 
     std::unique_ptr<Acceptor> acceptor_;
 
@@ -62,6 +116,22 @@ private:
     std::atomic_int started_;
 
     int64_t nextConnId_;
+    double idleTimeout_;
+    bool completionIo_;
+    bool edgeTriggered_;
+    bool acceptorPerLoop_;
+    int stallThresholdMs_;
+    // 在threadPool_之前析构：先停止检查再退出loop
+    std::unique_ptr<LoopWatchdog> watchdog_;
     ConnectionMap connectionMap_;
+    // 投递到各个loop的排空、强制关闭任务持有shared_ptr：finishStop清空之后，慢一些的loop还可能在执行这些任务
+    std::vector<std::shared_ptr<LoopAcceptor>> loopAcceptors_;
+
+    // 以下只在baseLoop中访问
+    bool stopping_;
+    // 还没有清空的链接表个数：baseLoop的一个加上每个loop各一个
+    size_t drainingMaps_;
+    TimerId drainTimer_;
+    StopCallback stopCallback_;
     
 };  
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "CurrentThread.h"
 
 #include <semaphore.h>              // sem_t
+#include <pthread.h>                // pthread_setname_np
 
 
 void Thread::setDefaultName()
@@ -43,6 +44,8 @@ void Thread::start()
     thread_ = std::shared_ptr<std::thread>(new std::thread([&](){
         // 获取线程tid
         tid_ = CurrentThread::tid();
+        // 线程名出现在top -H、perf、gdb中，内核限制最长15个字符
+        pthread_setname_np(pthread_self(), name_.substr(0, 15).c_str());
         // 子线程完成初始化操作，通知主线程
         sem_post(&sem);
         // 子线程调用线程函数
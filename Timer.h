@@ -0,0 +1,42 @@
+#pragma once
+#include "noncopyable.h"
+#include "nonmoveable.h"
+#include "Timestamp.h"
+#include "Callbacks.h"
+
+#include <atomic>
+
+
+// 定时器：到期时间 + 回调 + 重复间隔，由TimerQueue持有并管理生命周期
+class Timer : private noncopyable, private nonmoveable
+{
+public:
+    Timer(TimerCallback cb, Timestamp when, double interval)
+        : callback_(std::move(cb))
+        , expiration_(when)
+        , interval_(interval)
+        , repeat_(interval > 0.0)
+        , sequence_(++numCreated_) {}
+
+    void run() const { callback_(); }
+
+    Timestamp expiration() const { return expiration_; }
+    bool repeat() const { return repeat_; }
+    int64_t sequence() const { return sequence_; }
+
+    // 重复定时器到期后以now为基准计算下一次到期时间
+    void restart(Timestamp now);
+
+    static int64_t numCreated() { return numCreated_; }
+
+private:
+    const TimerCallback callback_;
+    Timestamp expiration_;
+    // 重复间隔，单位秒，<=0表示一次性定时器
+    const double interval_;
+    const bool repeat_;
+    // 全局唯一序号：Timer对象被释放后地址可能被复用，取消定时器时用(地址, 序号)来唯一标识一个定时器
+    const int64_t sequence_;
+
+    inline static std::atomic<int64_t> numCreated_{0};
+};
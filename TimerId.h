@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>              // int64_t
+
+class Timer;
+
+
+// 提供给用户用来取消定时器的句柄，可以拷贝，不持有Timer的生命周期
+class TimerId
+{
+public:
+    TimerId()
+        : timer_(nullptr)
+        , sequence_(0) {}
+    TimerId(Timer* timer, int64_t seq)
+        : timer_(timer)
+        , sequence_(seq) {}
+
+    // TimerQueue::cancel需要访问内部的timer_与sequence_
+    friend class TimerQueue;
+
+private:
+    Timer* timer_;
+    int64_t sequence_;
+};
@@ -0,0 +1,64 @@
+#pragma once
+#include "noncopyable.h"
+#include "nonmoveable.h"
+#include "Timestamp.h"
+#include "Callbacks.h"
+#include "Channel.h"
+
+#include <set>
+#include <vector>
+#include <utility>              // pair
+
+class EventLoop;
+class Timer;
+class TimerId;
+
+
+/*
+每个EventLoop持有一个TimerQueue：
+1. 所有定时器共用一个timerfd，timerfd总是设置为最早到期的那个定时器的时间
+2. timerfd作为普通的Channel注册到Poller上，到期时和其他IO事件一样在loop线程中被处理
+3. 定时器按(到期时间, Timer*)保存在std::set中，插入、删除都是O(log n)
+*/
+class TimerQueue : private noncopyable, private nonmoveable
+{
+public:
+    explicit TimerQueue(EventLoop* loop);
+    ~TimerQueue();
+
+    // 线程安全：可以在其他线程调用，实际的插入操作会转到loop线程中执行
+    TimerId addTimer(TimerCallback cb, Timestamp when, double interval);
+    // 线程安全：同上
+    void cancel(TimerId timerId);
+
+private:
+    // 以到期时间排序，到期时间相同时用Timer地址区分
+    using Entry = std::pair<Timestamp, Timer*>;
+    using TimerList = std::set<Entry>;
+    // 以(Timer地址, 序号)排序，用于取消定时器时查找
+    using ActiveTimer = std::pair<Timer*, int64_t>;
+    using ActiveTimerSet = std::set<ActiveTimer>;
+
+    void addTimerInLoop(Timer* timer);
+    void cancelInLoop(TimerId timerId);
+    // timerfd可读：有定时器到期
+    void handleRead();
+    // 取出所有到期的定时器
+    std::vector<Entry> getExpired(Timestamp now);
+    // 重复定时器重新加入队列，一次性定时器释放
+    void reset(const std::vector<Entry>& expired, Timestamp now);
+    // 插入定时器，返回最早到期时间是否改变
+    bool insert(Timer* timer);
+
+    EventLoop* loop_;
+    const int timerfd_;
+    Channel timerfdChannel_;
+    // 持有已经插入的Timer对象的所有权，TimerQueue析构时统一释放；还在任务队列中的由任务持有
+    TimerList timers_;
+
+    // timers_与activeTimers_保存的是同一批定时器
+    ActiveTimerSet activeTimers_;
+    // 正在执行到期回调时，回调中取消的重复定时器不能再被reset重新加入
+    bool callingExpiredTimers_;
+    ActiveTimerSet cancelingTimers_;
+};
@@ -1,11 +1,20 @@
 #include "Timestamp.h"
 
+#include <sys/time.h>           // gettimeofday
+
+
+Timestamp Timestamp::now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return Timestamp(static_cast<int64_t>(tv.tv_sec) * kMicroSecondsPerSecond + tv.tv_usec);
+}
 
 std::string Timestamp::toString() const
 {
 
     // time_t类型在ubuntu2204-64是一个long int类型而int64_t是signed long int
-    time_t seconds = static_cast<time_t>(secondSinceEpoch_);
+    time_t seconds = secondsSinceEpoch();
 
     // C++11 值初始化
     char buf[32] = {0};
@@ -25,4 +34,3 @@ std::string Timestamp::toString() const
     
     return buf;
 }
-
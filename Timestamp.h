@@ -7,17 +7,50 @@
 class Timestamp
 {
 public:
-    // 默认构造，当Timestamp默认构造时对secondSinceEpoch_进行初始化，避免垃圾值
+    // 默认构造，当Timestamp默认构造时对microSecondsSinceEpoch_进行初始化，避免垃圾值
     Timestamp()
-        : secondSinceEpoch_(0) {}
-    explicit Timestamp(uint64_t secondSinceEpoch)
-        : secondSinceEpoch_(secondSinceEpoch) {}
+        : microSecondsSinceEpoch_(0) {}
+    explicit Timestamp(int64_t microSecondsSinceEpoch)
+        : microSecondsSinceEpoch_(microSecondsSinceEpoch) {}
     // 提供获取当前时间的方法，设置为静态方便匿名使用
-    static Timestamp now() { return Timestamp(time(nullptr)); }
+    static Timestamp now();
+    // 无效时间点，定时器队列用来表示"还没有到期时间"
+    static Timestamp invalid() { return Timestamp(); }
     // 输出字符串xxxx-xx-xx xx:xx:xx格式的时间
     std::string toString() const;
 
+    bool valid() const { return microSecondsSinceEpoch_ > 0; }
+    int64_t microSecondsSinceEpoch() const { return microSecondsSinceEpoch_; }
+    time_t secondsSinceEpoch() const { return static_cast<time_t>(microSecondsSinceEpoch_ / kMicroSecondsPerSecond); }
+
+    static constexpr int kMicroSecondsPerSecond = 1000 * 1000;
+
 private:
-    // 表示从1970年1月1日 00:00:00 开始计时，精确到秒
-    int64_t secondSinceEpoch_;
-};
\ No newline at end of file
+    // 表示从1970年1月1日 00:00:00 开始计时，精确到微秒：定时器需要比秒更细的精度
+    int64_t microSecondsSinceEpoch_;
+};
+
+// 定时器队列按到期时间排序，需要比较运算
+inline bool operator<(Timestamp lhs, Timestamp rhs)
+{
+    return lhs.microSecondsSinceEpoch() < rhs.microSecondsSinceEpoch();
+}
+
+inline bool operator==(Timestamp lhs, Timestamp rhs)
+{
+    return lhs.microSecondsSinceEpoch() == rhs.microSecondsSinceEpoch();
+}
+
+// 两个时间点的差值，单位秒
+inline double timeDifference(Timestamp high, Timestamp low)
+{
+    int64_t diff = high.microSecondsSinceEpoch() - low.microSecondsSinceEpoch();
+    return static_cast<double>(diff) / Timestamp::kMicroSecondsPerSecond;
+}
+
+// 在timestamp的基础上加上seconds秒
+inline Timestamp addTime(Timestamp timestamp, double seconds)
+{
+    int64_t delta = static_cast<int64_t>(seconds * Timestamp::kMicroSecondsPerSecond);
+    return Timestamp(timestamp.microSecondsSinceEpoch() + delta);
+}
@@ -0,0 +1,142 @@
+#include "TimingWheel.h"
+#include "EventLoop.h"
+
+#include <cmath>                // ceil
+
+
+TimingWheel::TimingWheel(EventLoop* loop, double tickSeconds, int numBuckets)
+    : loop_(loop)
+    , tickSeconds_(tickSeconds)
+    , buckets_(numBuckets)
+    , currentTick_(0)
+    , numEntries_(0)
+    , ticking_(false)
+    , expiring_(nullptr)
+{
+    for (Entry& head : buckets_)
+    {
+        head.prev = &head;
+        head.next = &head;
+    }
+}
+
+TimingWheel::~TimingWheel()
+{
+    // tick定时器属于同一个loop的TimerQueue，loop析构时一起释放，这里只释放还挂在时间轮上的条目
+    for (Entry& head : buckets_)
+    {
+        while (head.next != &head)
+        {
+            Entry* entry = head.next;
+            unlink(entry);
+            delete entry;
+        }
+    }
+}
+
+TimingWheel::Entry* TimingWheel::add(double timeoutSeconds, ExpireCallback cb)
+{
+    Entry* entry = new Entry;
+    entry->prev = nullptr;
+    entry->next = nullptr;
+    entry->timeoutTicks = static_cast<int64_t>(std::ceil(timeoutSeconds / tickSeconds_));
+    if (entry->timeoutTicks < 1)
+    {
+        entry->timeoutTicks = 1;
+    }
+    entry->deadline = deadlineFromNow(entry->timeoutTicks);
+    entry->callback = std::move(cb);
+    link(entry);
+    ++numEntries_;
+
+    if (!ticking_)
+    {
+        ticking_ = true;
+        tickTimer_ = loop_->runEvery(tickSeconds_, std::bind(&TimingWheel::onTick, this));
+    }
+    return entry;
+}
+
+void TimingWheel::touch(Entry* entry)
+{
+    // 只记录新的到期tick，等所在的桶转到时再挪动
+    entry->deadline = deadlineFromNow(entry->timeoutTicks);
+}
+
+void TimingWheel::remove(Entry* entry)
+{
+    if (entry == expiring_)
+    {
+        return;
+    }
+    if (linked(entry))
+    {
+        unlink(entry);
+    }
+    --numEntries_;
+    delete entry;
+}
+
+void TimingWheel::onTick()
+{
+    ++currentTick_;
+    Entry& head = buckets_[currentTick_ % buckets_.size()];
+
+    // 先把整个桶摘到临时链表上：没到期的条目可能被挂回同一个桶，回调中也可能remove其他条目
+    Entry pending;
+    if (head.next == &head)
+    {
+        pending.prev = pending.next = &pending;
+    }
+    else
+    {
+        pending.next = head.next;
+        pending.prev = head.prev;
+        pending.next->prev = &pending;
+        pending.prev->next = &pending;
+        head.prev = head.next = &head;
+    }
+
+    while (pending.next != &pending)
+    {
+        Entry* entry = pending.next;
+        unlink(entry);
+        if (entry->deadline > currentTick_)
+        {
+            // 被touch过或者还没转满圈数，挂到新的桶上
+            link(entry);
+        }
+        else
+        {
+            // 到期：回调返回之后再释放条目，回调执行期间它自己的std::function不能被析构
+            expiring_ = entry;
+            entry->callback();
+            expiring_ = nullptr;
+            --numEntries_;
+            delete entry;
+        }
+    }
+
+    if (numEntries_ == 0 && ticking_)
+    {
+        ticking_ = false;
+        loop_->cancel(tickTimer_);
+    }
+}
+
+void TimingWheel::link(Entry* entry)
+{
+    Entry& head = buckets_[entry->deadline % buckets_.size()];
+    entry->prev = head.prev;
+    entry->next = &head;
+    head.prev->next = entry;
+    head.prev = entry;
+}
+
+void TimingWheel::unlink(Entry* entry)
+{
+    entry->prev->next = entry->next;
+    entry->next->prev = entry->prev;
+    entry->prev = nullptr;
+    entry->next = nullptr;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "noncopyable.h"
+#include "nonmoveable.h"
+#include "TimerId.h"
+
+#include <functional>
+#include <vector>
+#include <cstdint>              // int64_t
+
+class EventLoop;
+
+
+/*
+每个EventLoop持有一个时间轮，用来管理大量连接的空闲超时：
+1. 整个时间轮只有一个tick定时器（TimerQueue中的runEvery），而不是每个连接一个定时器
+2. 桶的数量固定，条目按 到期tick % 桶数 挂在对应桶的双向链表上，超过一圈的条目到了对应的桶再判断是否真正到期
+3. touch只更新条目的到期tick，不移动链表节点：O(1)，连接每次读写都调用也几乎没有开销
+   条目所在的桶转到时如果发现到期tick被推后了，再把它挪到新的桶里（每个超时周期最多挪一次）
+时间轮不是线程安全的，所有操作都必须在所属loop线程中进行
+*/
+class TimingWheel : private noncopyable, private nonmoveable
+{
+public:
+    using ExpireCallback = std::function<void()>;
+
+    // 侵入式链表节点，由时间轮分配与释放
+    struct Entry
+    {
+        Entry* prev;
+        Entry* next;
+        // 到期的tick
+        int64_t deadline;
+        // 超时时长，单位tick
+        int64_t timeoutTicks;
+        ExpireCallback callback;
+    };
+
+    TimingWheel(EventLoop* loop, double tickSeconds = 1.0, int numBuckets = 64);
+    ~TimingWheel();
+
+    // 添加一个条目，timeoutSeconds秒内没有被touch就调用cb
+    // 没有到期的条目由调用者通过remove释放；到期的条目在cb返回后由时间轮释放，调用者不能再使用
+    Entry* add(double timeoutSeconds, ExpireCallback cb);
+    // 刷新条目的到期时间，O(1)
+    void touch(Entry* entry);
+    // 将条目从时间轮上移除并释放；在条目自己的到期回调中调用时什么也不做，回调返回后由时间轮释放
+    void remove(Entry* entry);
+
+    size_t size() const { return numEntries_; }
+    double tickSeconds() const { return tickSeconds_; }
+
+private:
+    void onTick();
+    // 当前tick已经过去了一部分，多等一个tick保证至少空闲了timeoutTicks个完整的tick才到期
+    int64_t deadlineFromNow(int64_t timeoutTicks) const { return currentTick_ + timeoutTicks + 1; }
+    // 将条目挂到deadline对应的桶上
+    void link(Entry* entry);
+    static void unlink(Entry* entry);
+    static bool linked(const Entry* entry) { return entry->next != nullptr; }
+
+    EventLoop* loop_;
+    const double tickSeconds_;
+    // 每个桶是一个带哨兵的双向循环链表，哨兵只使用prev、next
+    std::vector<Entry> buckets_;
+    int64_t currentTick_;
+    size_t numEntries_;
+    // 没有条目时取消tick定时器，不让空闲的loop每秒被唤醒
+    bool ticking_;
+    TimerId tickTimer_;
+    // 正在执行到期回调的条目
+    Entry* expiring_;
+};
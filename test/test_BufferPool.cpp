@@ -0,0 +1,282 @@
+#include "./../BufferPool.h"
+#include "./../Buffer.h"
+#include "./../ChainBuffer.h"
+#include "./../TcpConnection.h"
+#include "./../EventLoopThread.h"
+#include "./../EventLoop.h"
+#include "./../InetAddress.h"
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+using namespace std;
+
+// 在loop线程中执行f并等待结果
+template <typename F>
+auto runSync(EventLoop* loop, F f) -> decltype(f())
+{
+    promise<decltype(f())> prom;
+    auto fut = prom.get_future();
+    loop->runInLoop([&]() {
+        if constexpr (is_void_v<decltype(f())>)
+        {
+            f();
+            prom.set_value();
+        }
+        else
+        {
+            prom.set_value(f());
+        }
+    });
+    return fut.get();
+}
+
+// 测试1: 分级分配与复用，超过最大级别的请求不缓存
+void testSizeClasses() {
+    cout << "=== 测试1: 分级分配与复用 ===" << endl;
+    EventLoopThread t;
+    EventLoop* loop = t.startLoop();
+    runSync(loop, [&]() {
+        BufferPool pool(loop);
+        size_t capacity = 0;
+        char* a = pool.allocate(100, &capacity);
+        assert(capacity == 1024);
+        pool.deallocate(a, capacity);
+        assert(pool.cachedBytes() == 1024);
+        char* b = pool.allocate(1000, &capacity);
+        assert(b == a && capacity == 1024);
+        assert(pool.reuses() == 1);
+        pool.deallocate(b, capacity);
+
+        char* c = pool.allocate(5000, &capacity);
+        assert(capacity == 8192);
+        pool.deallocate(c, capacity);
+
+        char* large = pool.allocate(BufferPool::kMaxClassSize + 1, &capacity);
+        // 超过最大级别按2的幂取整
+        assert(capacity == 2 * BufferPool::kMaxClassSize);
+        pool.deallocate(large, capacity);
+        assert(pool.cachedBytes() == 1024 + 8192);
+    });
+
+    // 其他线程的分配和释放直接走系统，不碰空闲链表
+    BufferPool* pool = loop->bufferPool();
+    size_t before = runSync(loop, [&]() { return pool->cachedBytes(); });
+    size_t capacity = 0;
+    char* p = pool->allocate(2048, &capacity);
+    pool->deallocate(p, capacity);
+    assert(runSync(loop, [&]() { return pool->cachedBytes(); }) == before);
+    cout << "✅ 测试1通过" << endl;
+}
+
+// 测试2: Buffer第一次写入时才挂上存储，排空后归还；突发撑大的存储也归还
+void testLazyBuffer() {
+    cout << "=== 测试2: 缓冲区按需挂上存储，排空归还 ===" << endl;
+    EventLoopThread t;
+    EventLoop* loop = t.startLoop();
+    runSync(loop, [&]() {
+        BufferPool pool(loop);
+        Buffer buf(&pool);
+        assert(buf.readableBytes() == 0);
+        assert(buf.writableBytes() == 0);
+
+        buf.append("hello", 5);
+        assert(buf.retrieveAllAsString() == "hello");
+        assert(buf.writableBytes() == 0);
+        assert(pool.cachedBytes() == 1024);
+
+        // 突发：逐步增长到64KB以上
+        string chunk(4096, 'x');
+        for (int i = 0; i < 64; ++i) {
+            buf.append(chunk.data(), chunk.size());
+        }
+        assert(buf.readableBytes() == 64 * 4096);
+        buf.retrieve(100);
+        assert(buf.readableBytes() == 64 * 4096 - 100);
+        buf.retrieveAll();
+        assert(buf.writableBytes() == 0);
+        // 增长过程中换下来的各级存储都回到了池中，超过64KB的直接还给系统
+        size_t cached = pool.cachedBytes();
+        cout << "突发后池中缓存: " << cached << " 字节" << endl;
+        assert(cached <= 2 * BufferPool::kMaxClassSize);
+
+        ChainBuffer chain(&pool);
+        string data(100 * 1024, 'y');
+        uint64_t reusesBefore = pool.reuses();
+        chain.append(data.data(), data.size());
+        assert(pool.reuses() == reusesBefore + 1);
+        chain.retrieveAll();
+        // 第一个块复用了突发时换下来的16KB存储，7个块全部回到池中
+        assert(pool.cachedBytes() == cached + 6 * ChainBuffer::kBlockSize);
+    });
+    cout << "✅ 测试2通过" << endl;
+}
+
+// 测试3: 一个周期内没有被取用的缓存被回收
+void testTrim() {
+    cout << "=== 测试3: 空闲缓存定期回收 ===" << endl;
+    EventLoopThread t;
+    EventLoop* loop = t.startLoop();
+    BufferPool* pool = nullptr;
+    runSync(loop, [&]() {
+        pool = new BufferPool(loop, 0.05);
+        vector<pair<char*, size_t>> blocks;
+        for (int i = 0; i < 100; ++i) {
+            size_t capacity = 0;
+            char* p = pool->allocate(16 * 1024, &capacity);
+            blocks.emplace_back(p, capacity);
+        }
+        for (auto& b : blocks) {
+            pool->deallocate(b.first, b.second);
+        }
+        assert(pool->cachedBytes() == 100 * 16 * 1024);
+    });
+    this_thread::sleep_for(chrono::milliseconds(300));
+    size_t cached = runSync(loop, [&]() { return pool->cachedBytes(); });
+    uint64_t trimmed = runSync(loop, [&]() { return pool->trimmedBytes(); });
+    cout << "回收: " << trimmed << " 字节，剩余缓存: " << cached << " 字节" << endl;
+    assert(cached == 0);
+    assert(trimmed == 100 * 16 * 1024);
+    runSync(loop, [&]() { delete pool; });
+    cout << "✅ 测试3通过" << endl;
+}
+
+// 测试4: 链接的缓冲区使用所属loop的内存池，空闲链接不占存储
+void testConnectionBuffers() {
+    cout << "=== 测试4: 链接的缓冲区从loop的内存池分配 ===" << endl;
+    EventLoopThread t;
+    EventLoop* loop = t.startLoop();
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    InetAddress addr("127.0.0.1", 0);
+    auto conn = make_shared<TcpConnection>(loop, "pooled", fds[0], addr, addr);
+    conn->setConnectionCallback([](const TcpConnectionPtr&) {});
+    conn->setCloseCallback([](const TcpConnectionPtr&) {});
+    promise<void> got;
+    int messages = 0;
+    const int kMessages = 20;
+    conn->setMessageCallback([&](const TcpConnectionPtr& c, Buffer* buf, Timestamp) {
+        messages += static_cast<int>(buf->readableBytes() / 4);
+        c->send(buf->retrieveAllAsString());
+        if (messages == kMessages) {
+            got.set_value();
+        }
+    });
+    runSync(loop, [&]() { conn->connectEstablished(); });
+
+    BufferPool* pool = loop->bufferPool();
+    uint64_t reusesBefore = runSync(loop, [&]() { return pool->reuses(); });
+    for (int i = 0; i < kMessages; ++i) {
+        assert(write(fds[1], "ping", 4) == 4);
+        char buf[4];
+        assert(read(fds[1], buf, sizeof(buf)) == 4);
+    }
+    got.get_future().wait();
+    uint64_t reuses = runSync(loop, [&]() { return pool->reuses(); }) - reusesBefore;
+    cout << "存储复用次数: " << reuses << endl;
+    // 每条消息取完后输入缓冲区都把存储还回去，下一条再从池中取
+    assert(reuses >= kMessages - 1);
+
+    runSync(loop, [&]() { conn->connectDestroyed(); });
+    close(fds[1]);
+    cout << "✅ 测试4通过" << endl;
+}
+
+// 测试5: 链接比所属loop活得久，在其他线程析构时存储直接还给系统
+void testConnectionOutlivesLoop() {
+    cout << "=== 测试5: 链接在loop析构之后析构 ===" << endl;
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    InetAddress addr("127.0.0.1", 0);
+    TcpConnectionPtr conn;
+    shared_ptr<BufferPool> pool;
+    {
+        EventLoopThread t;
+        EventLoop* loop = t.startLoop();
+        pool = loop->sharedBufferPool();
+        conn = make_shared<TcpConnection>(loop, "outlives", fds[0], addr, addr);
+        conn->setConnectionCallback([](const TcpConnectionPtr&) {});
+        conn->setCloseCallback([](const TcpConnectionPtr&) {});
+        promise<void> got;
+        // 不取走数据：输入缓冲区一直占着池中的存储
+        conn->setMessageCallback([&](const TcpConnectionPtr&, Buffer*, Timestamp) { got.set_value(); });
+        runSync(loop, [&]() { conn->connectEstablished(); });
+        assert(write(fds[1], "ping", 4) == 4);
+        got.get_future().wait();
+        // 对端不读，输出缓冲区也留下数据
+        runSync(loop, [&]() {
+            conn->send(string(4 * 1024 * 1024, 'x'));
+            conn->connectDestroyed();
+        });
+    }
+    // loop已经析构：内存池不再缓存，也不再属于任何线程
+    assert(pool->cachedBytes() == 0);
+    assert(pool.use_count() == 2);
+    conn.reset();
+    assert(pool.use_count() == 1);
+    assert(pool->cachedBytes() == 0);
+    size_t capacity = 0;
+    char* data = pool->allocate(100, &capacity);
+    pool->deallocate(data, capacity);
+    assert(pool->cachedBytes() == 0);
+    close(fds[1]);
+    cout << "✅ 测试5通过" << endl;
+}
+
+// 数据一直不取走时逐次append，返回重新分配存储的次数
+size_t countGrowths(Buffer& buf, int appends, size_t chunkSize) {
+    string chunk(chunkSize, 'g');
+    size_t growths = 0;
+    for (int i = 0; i < appends; ++i) {
+        const char* before = buf.peek();
+        buf.append(chunk.data(), chunk.size());
+        if (buf.peek() != before) {
+            ++growths;
+        }
+    }
+    assert(buf.readableBytes() == appends * chunkSize);
+    return growths;
+}
+
+// 测试6: 缓冲区几何增长，大消息连续写入时重新分配的次数是对数级的
+void testGeometricGrowth() {
+    cout << "=== 测试6: 缓冲区几何增长 ===" << endl;
+    const int kAppends = 4096;
+    const size_t kChunk = 4096;
+    auto start = chrono::steady_clock::now();
+    Buffer plain;
+    size_t plainGrowths = countGrowths(plain, kAppends, kChunk);
+
+    EventLoopThread t;
+    EventLoop* loop = t.startLoop();
+    size_t pooledGrowths = runSync(loop, [&]() {
+        Buffer pooled(loop->bufferPool());
+        return countGrowths(pooled, kAppends, kChunk);
+    });
+    auto ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+    cout << "重新分配次数: 普通 " << plainGrowths << "，内存池 " << pooledGrowths << "，耗时 " << ms << "ms" << endl;
+    // 16MB数据：翻倍增长最多二十多次，恰好够用的增长每次append都要重新分配
+    assert(plainGrowths <= 32);
+    assert(pooledGrowths <= 32);
+    cout << "✅ 测试6通过" << endl;
+}
+
+int main() {
+    testSizeClasses();
+    testLazyBuffer();
+    testTrim();
+    testConnectionBuffers();
+    testConnectionOutlivesLoop();
+    testGeometricGrowth();
+    cout << "🎉 所有 BufferPool 测试通过！" << endl;
+    return 0;
+}
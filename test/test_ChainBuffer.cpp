@@ -0,0 +1,125 @@
+#include "./../ChainBuffer.h"
+#include "./../Buffer.h"
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+using namespace std;
+
+static string pattern(size_t len, size_t seed = 0) {
+    string s(len, '\0');
+    for (size_t i = 0; i < len; ++i) {
+        s[i] = static_cast<char>('a' + (i + seed) % 26);
+    }
+    return s;
+}
+
+// 测试1: 跨块追加与取出
+void testAppendRetrieve() {
+    cout << "=== 测试1: 跨块追加与取出 ===" << endl;
+    ChainBuffer buf;
+    assert(buf.readableBytes() == 0);
+    assert(buf.peek() == nullptr);
+
+    string data = pattern(ChainBuffer::kBlockSize * 3 + 100);
+    buf.append(data.data(), 10);
+    buf.append(data.data() + 10, data.size() - 10);
+    assert(buf.readableBytes() == data.size());
+    assert(buf.numBlocks() == 4);
+    assert(buf.contiguousBytes() == ChainBuffer::kBlockSize);
+    assert(string(buf.peek(), 5) == data.substr(0, 5));
+
+    // 取出跨越块边界的一段
+    assert(buf.retrieveAsString(ChainBuffer::kBlockSize + 7) == data.substr(0, ChainBuffer::kBlockSize + 7));
+    assert(buf.numBlocks() == 3);
+    assert(buf.contiguousBytes() == ChainBuffer::kBlockSize - 7);
+    buf.retrieve(ChainBuffer::kBlockSize - 7);
+    assert(buf.numBlocks() == 2);
+    assert(buf.retrieveAllAsString() == data.substr(ChainBuffer::kBlockSize * 2));
+    assert(buf.readableBytes() == 0);
+    assert(buf.numBlocks() == 0);
+
+    buf.append("abc", 3);
+    ChainBuffer other;
+    other.swap(buf);
+    assert(buf.readableBytes() == 0);
+    assert(other.retrieveAllAsString() == "abc");
+    cout << "✅ 测试1通过" << endl;
+}
+
+// 测试2: writeFd一次writev发送多个块，readFd直接读进块中
+void testReadWriteFd() {
+    cout << "=== 测试2: writev发送与readv接收 ===" << endl;
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+
+    const string data = pattern(1024 * 1024, 3);
+    ChainBuffer out;
+    out.append(data.data(), data.size());
+    ChainBuffer in;
+    int savedErrno = 0;
+    int writes = 0;
+    while (out.readableBytes() > 0 || in.readableBytes() < data.size()) {
+        if (out.readableBytes() > 0) {
+            ssize_t n = out.writeFd(fds[0], &savedErrno);
+            if (n > 0) {
+                out.retrieve(n);
+                ++writes;
+            } else {
+                assert(savedErrno == EAGAIN);
+            }
+        }
+        ssize_t n = in.readFd(fds[1], &savedErrno);
+        assert(n > 0 || savedErrno == EAGAIN);
+    }
+    cout << "writev次数: " << writes << " 接收块数: " << in.numBlocks() << endl;
+    assert(in.readableBytes() == data.size());
+    assert(in.retrieveAllAsString() == data);
+
+    // 对端关闭时readFd返回0，不留下空块
+    close(fds[0]);
+    assert(in.readFd(fds[1], &savedErrno) == 0);
+    assert(in.numBlocks() == 0);
+    close(fds[1]);
+    cout << "✅ 测试2通过" << endl;
+}
+
+// 发送缓冲区积压：每次追加4KB，每次只发出3KB，积压到kBacklog字节后全部发完
+template <typename B>
+double backlogMs(size_t backlog) {
+    B buf;
+    string chunk = pattern(4096);
+    auto start = chrono::steady_clock::now();
+    while (buf.readableBytes() < backlog) {
+        buf.append(chunk.data(), chunk.size());
+        buf.retrieve(3072);
+    }
+    while (buf.readableBytes() > 0) {
+        buf.retrieve(64 * 1024);
+    }
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+void testBacklogGrowth() {
+    cout << "=== 测试3: 积压数MB时追加不搬动数据 ===" << endl;
+    const size_t kBacklog = 4 * 1024 * 1024;
+    double bufferMs = backlogMs<Buffer>(kBacklog);
+    double chainMs = backlogMs<ChainBuffer>(kBacklog);
+    cout << "积压" << kBacklog / 1024 / 1024 << "MB: Buffer " << bufferMs << "ms, ChainBuffer " << chainMs << "ms" << endl;
+    cout << "✅ 测试3通过" << endl;
+}
+
+int main() {
+    testAppendRetrieve();
+    testReadWriteFd();
+    testBacklogGrowth();
+    cout << "🎉 所有 ChainBuffer 测试通过！" << endl;
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include "./../ChannelTable.h"
+#include "./../Channel.h"
+#include "./../EventLoop.h"
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+#include <chrono>
+#include <memory>
+#include <cassert>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+// 测试1: 插入、查找、删除以及计数
+void testBasic() {
+    cout << "=== 测试1: 基本操作 ===" << endl;
+
+    ChannelTable table;
+    Channel* a = reinterpret_cast<Channel*>(0x10);
+    Channel* b = reinterpret_cast<Channel*>(0x20);
+    assert(table.size() == 0);
+    assert(table.find(-1) == nullptr);
+    assert(table.find(0) == nullptr);
+    assert(table.find(1000) == nullptr);
+
+    table.insert(3, a);
+    table.insert(1000, b);
+    assert(table.size() == 2);
+    assert(table.find(3) == a);
+    assert(table.find(1000) == b);
+    assert(table.find(4) == nullptr);
+
+    // 同一个fd重复插入只替换，不增加计数
+    table.insert(3, b);
+    assert(table.size() == 2);
+    assert(table.find(3) == b);
+
+    table.erase(3);
+    table.erase(3);
+    table.erase(5000);
+    assert(table.size() == 1);
+    assert(table.find(3) == nullptr);
+
+    cout << "=== 测试1通过 ===\n" << endl;
+}
+
+// 测试2: 通过真实的Poller注册、注销channel
+void testPollerRegistration() {
+    cout << "=== 测试2: Poller注册 ===" << endl;
+
+    EventLoop loop;
+    vector<int> fds;
+    vector<unique_ptr<Channel>> channels;
+    for (int i = 0; i < 16; ++i) {
+        int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        fds.push_back(fd);
+        channels.push_back(make_unique<Channel>(&loop, fd));
+        channels.back()->enableReading();
+        assert(loop.hasChannel(channels.back().get()));
+    }
+    for (size_t i = 0; i < channels.size(); i += 2) {
+        channels[i]->disableAll();
+        channels[i]->remove();
+        assert(!loop.hasChannel(channels[i].get()));
+        assert(loop.hasChannel(channels[i + 1].get()));
+    }
+    for (size_t i = 1; i < channels.size(); i += 2) {
+        channels[i]->disableAll();
+        channels[i]->remove();
+    }
+    for (int fd : fds) {
+        ::close(fd);
+    }
+
+    cout << "=== 测试2通过 ===\n" << endl;
+}
+
+// 测试3: 连接建立断开的抖动基准，和unordered_map对比
+void benchmarkChurn() {
+    cout << "=== 测试3: 连接抖动基准 ===" << endl;
+
+    constexpr int kLive = 1000;
+    constexpr int kRounds = 200;
+    Channel* dummy = reinterpret_cast<Channel*>(0x10);
+
+    // 模拟kLive个并发连接，每轮全部断开再重新建立，每个fd都查找一次
+    auto runMap = [&]() {
+        unordered_map<int, Channel*> map;
+        size_t hits = 0;
+        for (int r = 0; r < kRounds; ++r) {
+            for (int fd = 0; fd < kLive; ++fd) map[fd] = dummy;
+            for (int fd = 0; fd < kLive; ++fd) hits += map.find(fd) != map.end();
+            for (int fd = 0; fd < kLive; ++fd) map.erase(fd);
+        }
+        return hits;
+    };
+    auto runTable = [&]() {
+        ChannelTable table;
+        size_t hits = 0;
+        for (int r = 0; r < kRounds; ++r) {
+            for (int fd = 0; fd < kLive; ++fd) table.insert(fd, dummy);
+            for (int fd = 0; fd < kLive; ++fd) hits += table.find(fd) != nullptr;
+            for (int fd = 0; fd < kLive; ++fd) table.erase(fd);
+        }
+        return hits;
+    };
+
+    auto begin = chrono::steady_clock::now();
+    size_t mapHits = runMap();
+    auto mid = chrono::steady_clock::now();
+    size_t tableHits = runTable();
+    auto end = chrono::steady_clock::now();
+    assert(mapHits == static_cast<size_t>(kLive) * kRounds);
+    assert(tableHits == mapHits);
+
+    cout << "   unordered_map: " << chrono::duration_cast<chrono::microseconds>(mid - begin).count() << " us" << endl;
+    cout << "   ChannelTable:  " << chrono::duration_cast<chrono::microseconds>(end - mid).count() << " us" << endl;
+    cout << "=== 测试3通过 ===\n" << endl;
+}
+
+int main() {
+    cout << "开始 ChannelTable 测试套件\n" << endl;
+
+    testBasic();
+    testPollerRegistration();
+    benchmarkChurn();
+
+    cout << string(60, '=') << endl;
+    cout << "🎉 所有 ChannelTable 测试通过！" << endl;
+    cout << string(60, '=') << endl;
+    return 0;
+}
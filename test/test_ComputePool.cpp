@@ -0,0 +1,119 @@
+#include "./../ComputePool.h"
+#include "./../EventLoop.h"
+#include "./../EventLoopThread.h"
+#include "./../CurrentThread.h"
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <future>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <string>
+#include <memory>
+#include <cassert>
+
+using namespace std;
+
+// 测试1: 大量任务每个都恰好执行一次
+void testAllTasksRun() {
+    cout << "=== 测试1: 所有任务执行一次 ===" << endl;
+
+    constexpr int kTasks = 10000;
+    atomic<int64_t> sum{0};
+    {
+        ComputePool pool(4);
+        for (int i = 1; i <= kTasks; ++i) {
+            pool.submit([i, &sum]() { sum += i; });
+        }
+        // 析构时执行完已经提交的任务
+    }
+    assert(sum == static_cast<int64_t>(kTasks) * (kTasks + 1) / 2);
+
+    cout << "=== 测试1通过 ===\n" << endl;
+}
+
+// 测试2: 一个工作线程提交的子任务进入自己的队列，空闲的线程把它们偷走
+void testWorkStealing() {
+    cout << "=== 测试2: 偷任务 ===" << endl;
+
+    constexpr int kChildren = 64;
+    ComputePool pool(4, "StealPool");
+    mutex mtx;
+    set<pid_t> threads;
+    promise<void> done;
+    atomic<int> remaining{kChildren};
+
+    pool.submit([&]() {
+        for (int i = 0; i < kChildren; ++i) {
+            pool.submit([&]() {
+                this_thread::sleep_for(chrono::milliseconds(2));
+                {
+                    lock_guard<mutex> lock(mtx);
+                    threads.insert(CurrentThread::tid());
+                }
+                if (--remaining == 0) {
+                    done.set_value();
+                }
+            });
+        }
+    });
+    done.get_future().wait();
+
+    cout << "   偷走的任务: " << pool.stolen() << "，参与执行的线程: " << threads.size() << endl;
+    assert(pool.stolen() > 0);
+    assert(threads.size() > 1);
+
+    cout << "=== 测试2通过 ===\n" << endl;
+}
+
+// 测试3: 计算结果回到提交任务的loop线程
+void testResultToLoop() {
+    cout << "=== 测试3: 结果回到loop ===" << endl;
+
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+    ComputePool pool(2);
+
+    promise<pair<int, bool>> result;
+    promise<bool> voidDone;
+    loop->runInLoop([&]() {
+        pid_t loopTid = CurrentThread::tid();
+        pool.submit(loop,
+                    [loopTid]() {
+                        // 在计算线程执行
+                        assert(CurrentThread::tid() != loopTid);
+                        return 6 * 7;
+                    },
+                    [&result, loop](int value) {
+                        result.set_value({value, loop->isInLoopThread()});
+                    });
+        // 只能移动的结果和没有返回值的任务
+        pool.submit(loop,
+                    []() { return make_unique<string>("moved"); },
+                    [](unique_ptr<string> s) { assert(*s == "moved"); });
+        pool.submit(loop,
+                    []() {},
+                    [&voidDone, loop]() { voidDone.set_value(loop->isInLoopThread()); });
+    });
+
+    auto r = result.get_future().get();
+    assert(r.first == 42);
+    assert(r.second);
+    assert(voidDone.get_future().get());
+
+    cout << "=== 测试3通过 ===\n" << endl;
+}
+
+int main() {
+    cout << "开始 ComputePool 测试套件\n" << endl;
+
+    testAllTasksRun();
+    testWorkStealing();
+    testResultToLoop();
+
+    cout << string(60, '=') << endl;
+    cout << "🎉 所有 ComputePool 测试通过！" << endl;
+    cout << string(60, '=') << endl;
+    return 0;
+}
@@ -0,0 +1,320 @@
+// 需要C++20编译：g++ -std=c++20 ... test/test_Coroutine.cpp
+#include "./../Coroutine.h"
+#include "./../FramePool.h"
+#include "./../TcpConnection.h"
+#include "./../EventLoopThread.h"
+#include "./../EventLoop.h"
+#include "./../InetAddress.h"
+#include "./../Timestamp.h"
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+using namespace std;
+
+// 在loop线程中执行f并等待结果
+template <typename F>
+auto runSync(EventLoop* loop, F f) -> decltype(f())
+{
+    promise<decltype(f())> prom;
+    auto fut = prom.get_future();
+    loop->runInLoop([&]() {
+        if constexpr (is_void_v<decltype(f())>)
+        {
+            f();
+            prom.set_value();
+        }
+        else
+        {
+            prom.set_value(f());
+        }
+    });
+    return fut.get();
+}
+
+// 用socketpair的一端建立链接，另一端留给测试线程读写
+TcpConnectionPtr makeConnection(EventLoop* loop, int fds[2], const string& name)
+{
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    InetAddress addr("127.0.0.1", 0);
+    auto conn = make_shared<TcpConnection>(loop, name, fds[0], addr, addr);
+    conn->setConnectionCallback([](const TcpConnectionPtr&) {});
+    conn->setCloseCallback([](const TcpConnectionPtr&) {});
+    runSync(loop, [&]() { conn->connectEstablished(); });
+    return conn;
+}
+
+void writeAll(int fd, const string& data)
+{
+    assert(write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size()));
+}
+
+CoTask readAtLeastTask(TcpConnectionPtr conn, size_t n, promise<string>* result)
+{
+    Buffer* buf = co_await conn->readAtLeast(n);
+    result->set_value(buf ? buf->retrieveAllAsString() : string("<closed>"));
+}
+
+void testReadAtLeast()
+{
+    cout << "=== 测试1: readAtLeast等到足够的字节才恢复 ===" << endl;
+    EventLoopThread t;
+    EventLoop* loop = t.startLoop();
+    int fds[2];
+    auto conn = makeConnection(loop, fds, "co-read");
+    bool messageCalled = false;
+    conn->setMessageCallback([&](const TcpConnectionPtr&, Buffer*, Timestamp) { messageCalled = true; });
+
+    promise<string> result;
+    auto fut = result.get_future();
+    runSync(loop, [&]() { readAtLeastTask(conn, 6, &result); });
+
+    writeAll(fds[1], "ab");
+    assert(fut.wait_for(chrono::milliseconds(100)) == future_status::timeout);
+    writeAll(fds[1], "cdef");
+    assert(fut.wait_for(chrono::seconds(1)) == future_status::ready);
+    assert(fut.get() == "abcdef");
+    // 协程在等待时数据不交给messageCallback
+    runSync(loop, []() {});
+    assert(!messageCalled);
+
+    runSync(loop, [&]() { conn->connectDestroyed(); });
+    close(fds[1]);
+    cout << "✅ 测试1通过" << endl;
+}
+
+CoTask readLinesTask(TcpConnectionPtr conn, promise<vector<string>>* result)
+{
+    vector<string> lines;
+    while (auto line = co_await conn->readUntil("\r\n"))
+    {
+        if (line->empty())
+        {
+            break;
+        }
+        lines.push_back(std::move(*line));
+    }
+    result->set_value(std::move(lines));
+}
+
+void testReadUntil()
+{
+    cout << "=== 测试2: readUntil按分隔符切分，分隔符可以跨两次到达 ===" << endl;
+    EventLoopThread t;
+    EventLoop* loop = t.startLoop();
+    int fds[2];
+    auto conn = makeConnection(loop, fds, "co-line");
+
+    promise<vector<string>> result;
+    auto fut = result.get_future();
+    runSync(loop, [&]() { readLinesTask(conn, &result); });
+
+    writeAll(fds[1], "GET / HTTP/1.1\r\nHost: x\r");
+    assert(fut.wait_for(chrono::milliseconds(100)) == future_status::timeout);
+    writeAll(fds[1], "\n\r\nbody");
+    assert(fut.wait_for(chrono::seconds(1)) == future_status::ready);
+    vector<string> lines = fut.get();
+    assert(lines.size() == 2);
+    assert(lines[0] == "GET / HTTP/1.1");
+    assert(lines[1] == "Host: x");
+    // 分隔符之后的数据留在缓冲区里
+    promise<string> rest;
+    auto restFut = rest.get_future();
+    runSync(loop, [&]() { readAtLeastTask(conn, 4, &rest); });
+    assert(restFut.get() == "body");
+
+    runSync(loop, [&]() { conn->connectDestroyed(); });
+    close(fds[1]);
+    cout << "✅ 测试2通过" << endl;
+}
+
+CoTask sendAndDrainTask(TcpConnectionPtr conn, string data, promise<bool>* sent, promise<bool>* drained)
+{
+    conn->send(data);
+    sent->set_value(true);
+    bool ok = co_await conn->drain();
+    drained->set_value(ok);
+}
+
+void testDrain()
+{
+    cout << "=== 测试3: drain在发送缓冲区写空之后恢复 ===" << endl;
+    EventLoopThread t;
+    EventLoop* loop = t.startLoop();
+    int fds[2];
+    auto conn = makeConnection(loop, fds, "co-drain");
+
+    const string data(4 * 1024 * 1024, 'x');
+    promise<bool> sent, drained;
+    auto sentFut = sent.get_future();
+    auto drainedFut = drained.get_future();
+    runSync(loop, [&]() { sendAndDrainTask(conn, data, &sent, &drained); });
+    assert(sentFut.get());
+    // 对端还没读，4MB放不进socket缓冲区，drain必须挂起
+    assert(drainedFut.wait_for(chrono::milliseconds(100)) == future_status::timeout);
+
+    size_t total = 0;
+    char buf[65536];
+    while (total < data.size())
+    {
+        ssize_t n = read(fds[1], buf, sizeof(buf));
+        assert(n > 0);
+        total += n;
+    }
+    assert(drainedFut.wait_for(chrono::seconds(1)) == future_status::ready);
+    assert(drainedFut.get());
+
+    runSync(loop, [&]() { conn->connectDestroyed(); });
+    close(fds[1]);
+    cout << "✅ 测试3通过" << endl;
+}
+
+CoTask sleepTask(EventLoop* loop, double seconds, promise<double>* elapsed)
+{
+    auto start = chrono::steady_clock::now();
+    co_await loop->sleepFor(seconds);
+    assert(loop->isInLoopThread());
+    elapsed->set_value(chrono::duration<double>(chrono::steady_clock::now() - start).count());
+}
+
+void testSleepFor()
+{
+    cout << "=== 测试4: sleepFor由loop的定时器恢复 ===" << endl;
+    EventLoopThread t;
+    EventLoop* loop = t.startLoop();
+    promise<double> elapsed;
+    auto fut = elapsed.get_future();
+    runSync(loop, [&]() { sleepTask(loop, 0.05, &elapsed); });
+    double seconds = fut.get();
+    cout << "sleepFor(0.05)实际等待: " << seconds * 1000 << "ms" << endl;
+    assert(seconds >= 0.045);
+    cout << "✅ 测试4通过" << endl;
+}
+
+void testDisconnectWakes()
+{
+    cout << "=== 测试5: 对端关闭时等待中的协程收到nullptr ===" << endl;
+    EventLoopThread t;
+    EventLoop* loop = t.startLoop();
+    int fds[2];
+    auto conn = makeConnection(loop, fds, "co-close");
+
+    promise<string> result;
+    auto fut = result.get_future();
+    runSync(loop, [&]() { readAtLeastTask(conn, 100, &result); });
+    writeAll(fds[1], "short");
+    close(fds[1]);
+    assert(fut.wait_for(chrono::seconds(1)) == future_status::ready);
+    assert(fut.get() == "<closed>");
+    assert(!conn->connected());
+    cout << "✅ 测试5通过" << endl;
+}
+
+CoTask drainTask(TcpConnectionPtr conn, promise<bool>* result)
+{
+    result->set_value(co_await conn->drain());
+}
+
+void testDestroyAfterShutdown()
+{
+    cout << "=== 测试7: shutdown之后直接销毁链接，等待中的协程也被恢复 ===" << endl;
+    EventLoopThread t;
+    EventLoop* loop = t.startLoop();
+    int fds[2];
+    auto conn = makeConnection(loop, fds, "co-shutdown");
+    // 对端不读，发送缓冲区留着数据，drain一直等待
+    string big(8 * 1024 * 1024, 'x');
+    promise<string> readResult;
+    promise<bool> drainResult;
+    runSync(loop, [&]() {
+        conn->send(big);
+        readAtLeastTask(conn, 100, &readResult);
+        drainTask(conn, &drainResult);
+    });
+    auto readFut = readResult.get_future();
+    auto drainFut = drainResult.get_future();
+    assert(readFut.wait_for(chrono::milliseconds(50)) == future_status::timeout);
+
+    // 和~TcpServer一样：链接处于kDisconnecting时直接connectDestroyed
+    conn->shutdown();
+    runSync(loop, [&]() { conn->connectDestroyed(); });
+    assert(readFut.wait_for(chrono::seconds(1)) == future_status::ready);
+    assert(readFut.get() == "<closed>");
+    assert(drainFut.wait_for(chrono::seconds(1)) == future_status::ready);
+    assert(!drainFut.get());
+    // 协程帧已经释放，不再持有链接
+    runSync(loop, []() {});
+    assert(conn.use_count() == 1);
+    close(fds[1]);
+    cout << "✅ 测试7通过" << endl;
+}
+
+CoTask countTask(EventLoop* loop, int* done)
+{
+    // 0秒不挂起，协程同步执行完，帧马上还给池
+    co_await loop->sleepFor(0);
+    ++*done;
+}
+
+void testFrameReuse()
+{
+    cout << "=== 测试6: 协程帧从loop线程的FramePool复用 ===" << endl;
+    EventLoopThread t;
+    EventLoop* loop = t.startLoop();
+    const int kTasks = 10000;
+    int done = 0;
+    auto stats = runSync(loop, [&]() {
+        FramePool& pool = FramePool::local();
+        uint64_t allocatedBefore = pool.allocated();
+        uint64_t reusedBefore = pool.reused();
+        for (int i = 0; i < kTasks; ++i)
+        {
+            countTask(loop, &done);
+        }
+        return make_pair(pool.allocated() - allocatedBefore, pool.reused() - reusedBefore);
+    });
+    cout << "新分配: " << stats.first << " 复用: " << stats.second << endl;
+    assert(done == kTasks);
+    assert(stats.first <= 1);
+    assert(stats.second >= static_cast<uint64_t>(kTasks - 1));
+
+    // 池本身的分级与缓存上限
+    FramePool pool;
+    vector<void*> frames;
+    for (size_t i = 0; i < FramePool::kMaxCachedPerClass + 10; ++i)
+    {
+        frames.push_back(pool.allocate(200));
+    }
+    void* large = pool.allocate(100000);
+    for (void* p : frames)
+    {
+        pool.deallocate(p);
+    }
+    pool.deallocate(large);
+    assert(pool.cached() == FramePool::kMaxCachedPerClass);
+    void* again = pool.allocate(256 - 64);
+    assert(pool.reused() == 1);
+    pool.deallocate(again);
+    cout << "✅ 测试6通过" << endl;
+}
+
+int main()
+{
+    testReadAtLeast();
+    testReadUntil();
+    testDrain();
+    testSleepFor();
+    testDisconnectWakes();
+    testFrameReuse();
+    testDestroyAfterShutdown();
+    cout << "🎉 所有 Coroutine 测试通过！" << endl;
+    return 0;
+}
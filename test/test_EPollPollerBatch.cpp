@@ -0,0 +1,457 @@
+#include "./../EventLoop.h"
+#include "./../Channel.h"
+#include "./../EventLoopThread.h"
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <utility>
+#include <cassert>
+#include <future>
+#include <chrono>
+#include <thread>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <dlfcn.h>
+
+using namespace std;
+
+// 截获epoll_ctl，记录每一次到达内核的(操作, fd)、失败的次数，以及是否有不在loop线程中的调用
+static vector<pair<int, int>> g_ctlCalls;
+static int g_ctlErrors = 0;
+static EventLoop* g_checkLoop = nullptr;
+static bool g_foreignCtl = false;
+
+extern "C" int epoll_ctl(int epfd, int op, int fd, struct epoll_event* event) noexcept
+{
+    using RealEpollCtl = int (*)(int, int, int, struct epoll_event*);
+    static RealEpollCtl real = reinterpret_cast<RealEpollCtl>(dlsym(RTLD_NEXT, "epoll_ctl"));
+    if (g_checkLoop != nullptr && !g_checkLoop->isInLoopThread()) {
+        g_foreignCtl = true;
+    }
+    g_ctlCalls.push_back({op, fd});
+    int ret = real(epfd, op, fd, event);
+    if (ret < 0) {
+        ++g_ctlErrors;
+    }
+    return ret;
+}
+
+// 某个fd从第from次调用开始的所有epoll_ctl操作
+static vector<int> ctlOps(int fd, size_t from = 0) {
+    vector<int> ops;
+    for (size_t i = from; i < g_ctlCalls.size(); ++i) {
+        if (g_ctlCalls[i].second == fd) {
+            ops.push_back(g_ctlCalls[i].first);
+        }
+    }
+    return ops;
+}
+
+// 依次在loop的每一轮中执行一个步骤，每一步之间都经过一次epoll_wait（变化在此之前提交）
+static void runSteps(EventLoop& loop, vector<function<void()>> steps) {
+    size_t next = 0;
+    function<void()> driver;
+    driver = [&]() {
+        if (next == steps.size()) {
+            loop.quit();
+            return;
+        }
+        steps[next++]();
+        loop.queueInLoop([&]() { driver(); });
+    };
+    loop.queueInLoop([&]() { driver(); });
+    // loop还没开始，在本线程投递任务不会唤醒
+    loop.wakeup();
+    loop.loop();
+}
+
+// 测试1: 同一轮中的多次修改合并成一次提交
+void testCoalesce() {
+    cout << "=== 测试1: 合并同一轮中的修改 ===" << endl;
+
+    EventLoop loop;
+    int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    Channel channel(&loop, fd);
+    size_t mark = 0;
+
+    runSteps(loop, {
+        [&]() {
+            // 新channel多次修改事件，提交前内核看不到任何操作
+            channel.enableReading();
+            channel.enableWriting();
+            channel.disableWriting();
+            assert(ctlOps(fd).empty());
+        },
+        [&]() {
+            // 只有一次ADD
+            assert(ctlOps(fd) == vector<int>{EPOLL_CTL_ADD});
+            mark = g_ctlCalls.size();
+            // 请求/响应周期中打开又关闭EPOLLOUT，最终状态和内核一致
+            channel.enableWriting();
+            channel.disableWriting();
+        },
+        [&]() {
+            assert(ctlOps(fd, mark).empty());
+            channel.enableWriting();
+        },
+        [&]() {
+            assert(ctlOps(fd, mark) == vector<int>{EPOLL_CTL_MOD});
+            mark = g_ctlCalls.size();
+            channel.disableAll();
+            channel.enableReading();
+            channel.disableAll();
+        },
+        [&]() {
+            assert(ctlOps(fd, mark) == vector<int>{EPOLL_CTL_DEL});
+            channel.remove();
+        },
+    });
+    ::close(fd);
+
+    cout << "=== 测试1通过 ===\n" << endl;
+}
+
+// 测试2: 同一轮中添加又移除的channel不会到达内核，已经提交的channel移除时立即删除
+void testAddThenRemove() {
+    cout << "=== 测试2: 添加后立即移除 ===" << endl;
+
+    EventLoop loop;
+    int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    Channel channel(&loop, fd);
+    size_t mark = 0;
+
+    runSteps(loop, {
+        [&]() {
+            mark = g_ctlCalls.size();
+            channel.enableReading();
+            channel.disableAll();
+            channel.remove();
+        },
+        [&]() {
+            assert(ctlOps(fd, mark).empty());
+            channel.enableReading();
+        },
+        [&]() {
+            mark = g_ctlCalls.size();
+            channel.disableAll();
+            channel.remove();
+            // 不等到下一次epoll_wait
+            assert(ctlOps(fd, mark) == vector<int>{EPOLL_CTL_DEL});
+        },
+    });
+    ::close(fd);
+
+    cout << "=== 测试2通过 ===\n" << endl;
+}
+
+// 测试3: fd关闭后被新channel复用，事件分发到新的channel
+void testFdReuse() {
+    cout << "=== 测试3: fd复用 ===" << endl;
+
+    EventLoop loop;
+    int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    Channel* oldChannel = new Channel(&loop, fd);
+    Channel* newChannel = nullptr;
+    int newFd = -1;
+    int reads = 0;
+
+    runSteps(loop, {
+        [&]() { oldChannel->enableReading(); },
+        [&]() {
+            oldChannel->disableAll();
+            oldChannel->remove();
+            delete oldChannel;
+            ::close(fd);
+            newFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            assert(newFd == fd);
+            newChannel = new Channel(&loop, newFd);
+            newChannel->setReadCallback([&](Timestamp) {
+                uint64_t value = 0;
+                ::read(newFd, &value, sizeof(value));
+                ++reads;
+            });
+            newChannel->enableReading();
+            uint64_t one = 1;
+            ::write(newFd, &one, sizeof(one));
+        },
+        [&]() {},
+        [&]() {
+            assert(reads == 1);
+            newChannel->disableAll();
+            newChannel->remove();
+        },
+    });
+    delete newChannel;
+    ::close(newFd);
+
+    cout << "=== 测试3通过 ===\n" << endl;
+}
+
+// 测试4: 事件数组随返回的事件数伸缩
+void testEventListSizing() {
+    cout << "=== 测试4: 事件数组自动伸缩 ===" << endl;
+
+    constexpr int kFds = 200;
+    EventLoop loop;
+    loop.setPollBatchSize(4, 64);
+    assert(loop.pollBatchSize() == 4);
+
+    vector<int> fds;
+    vector<unique_ptr<Channel>> channels;
+    bool drain = false;
+    for (int i = 0; i < kFds; ++i) {
+        int fd = ::eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+        fds.push_back(fd);
+        channels.push_back(make_unique<Channel>(&loop, fd));
+        // 水平触发：不读就一直就绪
+        channels.back()->setReadCallback([fd, &drain](Timestamp) {
+            if (drain) {
+                uint64_t value = 0;
+                ::read(fd, &value, sizeof(value));
+            }
+        });
+    }
+
+    int grown = 0;
+    vector<function<void()>> steps;
+    steps.push_back([&]() {
+        for (auto& channel : channels) channel->enableReading();
+    });
+    // 大量fd一直就绪：每次都填满数组，翻倍直到上限
+    for (int i = 0; i < 10; ++i) steps.push_back([]() {});
+    steps.push_back([&]() {
+        grown = loop.pollBatchSize();
+        drain = true;
+    });
+    // 读完之后每轮只有唤醒一个事件：滑动平均下降，逐步减半回到初始大小
+    for (int i = 0; i < 100; ++i) steps.push_back([]() {});
+    runSteps(loop, steps);
+
+    cout << "   扩大到: " << grown << "，收缩到: " << loop.pollBatchSize() << endl;
+    assert(grown == 64);
+    assert(loop.pollBatchSize() == 4);
+
+    for (auto& channel : channels) {
+        channel->disableAll();
+        channel->remove();
+    }
+    for (int fd : fds) {
+        ::close(fd);
+    }
+
+    cout << "=== 测试4通过 ===\n" << endl;
+}
+
+// 测试5: disableAll之后不经过remove直接关闭fd，不会留下推迟到关闭之后的EPOLL_CTL_DEL
+void testDisableThenClose() {
+    cout << "=== 测试5: disableAll后直接关闭fd ===" << endl;
+
+    EventLoop loop;
+    int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    Channel* channel = new Channel(&loop, fd);
+    size_t mark = 0;
+    int errors = 0;
+
+    runSteps(loop, {
+        [&]() { channel->enableReading(); },
+        [&]() {
+            mark = g_ctlCalls.size();
+            errors = g_ctlErrors;
+            channel->disableAll();
+            // 立即删除，不等到下一次epoll_wait
+            assert(ctlOps(fd, mark) == vector<int>{EPOLL_CTL_DEL});
+            ::close(fd);
+        },
+        [&]() {
+            // 关闭之后没有再对这个fd调用epoll_ctl
+            assert(ctlOps(fd, mark) == vector<int>{EPOLL_CTL_DEL});
+            assert(g_ctlErrors == errors);
+            channel->remove();
+        },
+    });
+    delete channel;
+
+    cout << "=== 测试5通过 ===\n" << endl;
+}
+
+// 测试6: 在其他线程中修改channel，投递到loop线程执行，不阻塞调用方
+void testForeignThreadUpdate() {
+    cout << "=== 测试6: 在其他线程中修改channel ===" << endl;
+
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+    g_checkLoop = loop;
+    g_foreignCtl = false;
+
+    int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    auto channel = make_unique<Channel>(loop, fd);
+    promise<bool> readInLoop;
+    channel->setReadCallback([&](Timestamp) {
+        uint64_t value = 0;
+        ::read(fd, &value, sizeof(value));
+        readInLoop.set_value(loop->isInLoopThread());
+    });
+
+    // loop正在执行一个任务时修改channel：立即返回，不等loop
+    promise<void> busy;
+    promise<void> release;
+    shared_future<void> released = release.get_future().share();
+    loop->runInLoop([&busy, released]() {
+        busy.set_value();
+        released.wait();
+    });
+    busy.get_future().wait();
+    channel->enableReading();
+    release.set_value();
+
+    uint64_t one = 1;
+    assert(::write(fd, &one, sizeof(one)) == sizeof(one));
+    auto result = readInLoop.get_future();
+    assert(result.wait_for(chrono::seconds(1)) == future_status::ready);
+    assert(result.get());
+
+    // 投递的移除执行完之后channel才能析构
+    channel->disableAll();
+    channel->remove();
+    promise<bool> removed;
+    loop->runInLoop([&]() { removed.set_value(!loop->hasChannel(channel.get())); });
+    assert(removed.get_future().get());
+    channel.reset();
+    ::close(fd);
+
+    g_checkLoop = nullptr;
+    assert(!g_foreignCtl);
+
+    // loop()还没开始时修改channel同样不阻塞，loop开始后生效
+    promise<EventLoop*> created;
+    promise<void> start;
+    bool added = false;
+    thread idleThread([&]() {
+        EventLoop idle;
+        created.set_value(&idle);
+        start.get_future().wait();
+        idle.queueInLoop([&]() {
+            added = idle.hasChannel(channel.get());
+            idle.quit();
+        });
+        idle.loop();
+        channel->disableAll();
+        channel->remove();
+    });
+    EventLoop* idle = created.get_future().get();
+    fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    channel = make_unique<Channel>(idle, fd);
+    channel->enableReading();
+    start.set_value();
+    idleThread.join();
+    assert(added);
+    channel.reset();
+    ::close(fd);
+
+    cout << "=== 测试6通过 ===\n" << endl;
+}
+
+// 一组水平触发的eventfd：drain为false时不读，一直就绪
+struct ReadyFds {
+    ReadyFds(EventLoop& loop, int count, bool& drain) {
+        for (int i = 0; i < count; ++i) {
+            int fd = ::eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+            fds.push_back(fd);
+            channels.push_back(make_unique<Channel>(&loop, fd));
+            channels.back()->setReadCallback([fd, &drain](Timestamp) {
+                if (drain) {
+                    uint64_t value = 0;
+                    ::read(fd, &value, sizeof(value));
+                }
+            });
+        }
+    }
+    ~ReadyFds() {
+        for (auto& channel : channels) {
+            channel->disableAll();
+            channel->remove();
+        }
+        for (int fd : fds) {
+            ::close(fd);
+        }
+    }
+    void enableAll() {
+        for (auto& channel : channels) channel->enableReading();
+    }
+
+    vector<int> fds;
+    vector<unique_ptr<Channel>> channels;
+};
+
+// 测试7: 稳定负载下数组大小不来回切换；0超时的空poll不会让突发后的数组马上收缩
+void testEventListHysteresis() {
+    cout << "=== 测试7: 事件数组伸缩的滞后 ===" << endl;
+
+    // 每轮稳定返回100个事件
+    {
+        EventLoop loop;
+        loop.setPollBatchSize(4, 256);
+        bool drain = false;
+        ReadyFds ready(loop, 100, drain);
+        vector<int> sizes;
+        vector<function<void()>> steps;
+        steps.push_back([&]() { ready.enableAll(); });
+        for (int i = 0; i < 60; ++i) steps.push_back([&]() { sizes.push_back(loop.pollBatchSize()); });
+        steps.push_back([&]() { drain = true; });
+        runSteps(loop, steps);
+
+        size_t firstFull = 0;
+        while (firstFull < sizes.size() && sizes[firstFull] != 128) ++firstFull;
+        assert(firstFull < sizes.size());
+        for (size_t i = firstFull; i < sizes.size(); ++i) {
+            assert(sizes[i] == 128);
+        }
+        cout << "   稳定负载: " << sizes.size() - firstFull << " 轮保持在 " << sizes.back() << endl;
+    }
+
+    // 忙轮询：突发之后的自旋都是返回0个事件的0超时poll
+    {
+        EventLoop loop;
+        loop.setPollBatchSize(4, 64);
+        loop.setBusyPoll(20000);
+        bool drain = false;
+        ReadyFds ready(loop, 200, drain);
+        int grown = 0;
+        int idle = 0;
+        loop.queueInLoop([&]() { ready.enableAll(); });
+        loop.wakeup();
+        loop.runAfter(0.05, [&]() {
+            grown = loop.pollBatchSize();
+            drain = true;
+        });
+        loop.runAfter(0.15, [&]() {
+            idle = loop.pollBatchSize();
+            loop.quit();
+        });
+        loop.loop();
+        cout << "   忙轮询: 突发扩大到 " << grown << "，空转 " << loop.spinPolls() << " 次后为 " << idle << endl;
+        assert(grown == 64);
+        assert(idle == 64);
+    }
+
+    cout << "=== 测试7通过 ===\n" << endl;
+}
+
+int main() {
+    cout << "开始 EPollPoller 批量提交测试套件\n" << endl;
+
+    testCoalesce();
+    testAddThenRemove();
+    testFdReuse();
+    testEventListSizing();
+    testDisableThenClose();
+    testForeignThreadUpdate();
+    testEventListHysteresis();
+
+    cout << string(60, '=') << endl;
+    cout << "🎉 所有 EPollPoller 批量提交测试通过！" << endl;
+    cout << string(60, '=') << endl;
+    return 0;
+}
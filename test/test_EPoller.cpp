@@ -53,6 +53,16 @@ private:
     int errorCount_ = 0;
 };
 
+// Channel的enable/disable会先经过loop自己的poller，两个poller共用channel的index：
+// 修改事件之后恢复成被测poller上次设置的状态，再交给被测poller
+template <typename F>
+void updateOn(EPollPoller& poller, Channel& channel, F change) {
+    int index = channel.index();
+    change();
+    channel.set_index(index);
+    poller.updateChannel(&channel);
+}
+
 // 创建测试用的socket pair
 int createSocketPair(int fds[2]) {
     assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
@@ -88,28 +98,23 @@ void testBasicOperations() {
     
     // 测试添加Channel到Poller
     cout << "1. 测试添加Channel到Poller" << endl;
-    channel.enableReading();
-    channel.set_index(kNew);
-    poller.updateChannel(&channel);
+    updateOn(poller, channel, [&]() { channel.enableReading(); });
     assert(channel.index() == 1);  // kAdded = 1
     
     // 测试修改Channel事件
     cout << "2. 测试修改Channel事件" << endl;
-    channel.enableWriting();
-    poller.updateChannel(&channel);
+    updateOn(poller, channel, [&]() { channel.enableWriting(); });
     assert(channel.index() == 1);  // 仍然是kAdded
     
     // 测试禁用所有事件
     cout << "3. 测试禁用所有事件" << endl;
-    channel.disableAll();
-    poller.updateChannel(&channel);
+    updateOn(poller, channel, [&]() { channel.disableAll(); });
     assert(channel.index() == 2);  // kDeleted = 2
     assert(channel.isNoneEvent());
     
     // 测试重新启用事件
     cout << "4. 测试重新启用事件" << endl;
-    channel.enableReading();
-    poller.updateChannel(&channel);
+    updateOn(poller, channel, [&]() { channel.enableReading(); });
     assert(channel.index() == 1);  // 变回kAdded
     
     // 测试从Poller中移除Channel
@@ -144,8 +149,7 @@ void testPollFunction() {
     channel.setErrorCallback([&callbacks]() { callbacks.onError(); });
     
     // 启用读事件
-    channel.enableReading();
-    poller.updateChannel(&channel);
+    updateOn(poller, channel, [&]() { channel.enableReading(); });
     assert(channel.index() == 1);
     
     // 在另一个socket上写数据，触发读事件
@@ -180,8 +184,7 @@ void testPollFunction() {
     // 测试写事件
     cout << "测试写事件" << endl;
     callbacks.resetCounters();
-    channel.enableWriting();
-    poller.updateChannel(&channel);
+    updateOn(poller, channel, [&]() { channel.enableWriting(); });
     
     activeChannels.clear();
     ts = poller.poll(100, &activeChannels);
@@ -190,7 +193,8 @@ void testPollFunction() {
     activeChannel = activeChannels[0];
     activeChannel->handleEvent(ts);
     assert(callbacks.writeCount() == 1);
-    assert(callbacks.readCount() == 1);
+    // 数据已经读完，只有写事件
+    assert(callbacks.readCount() == 0);
     
     close(fds[0]);
     close(fds[1]);
@@ -227,13 +231,13 @@ void testMultipleChannels() {
         });
         
         // 启用不同的事件
-        if (i % 2 == 0) {
-            channels[i]->enableReading();
-        } else {
-            channels[i]->enableWriting();
-        }
-        
-        poller.updateChannel(channels[i].get());
+        updateOn(poller, *channels[i], [&]() {
+            if (i % 2 == 0) {
+                channels[i]->enableReading();
+            } else {
+                channels[i]->enableWriting();
+            }
+        });
         assert(channels[i]->index() == 1);
     }
     
@@ -287,8 +291,7 @@ void testEdgeCases() {
         assert(createSocketPair(fds) == 0);
         Channel channel(&loop, fds[0]);
         channel.set_index(kNew);
-        channel.enableReading();
-        poller.updateChannel(&channel);
+        updateOn(poller, channel, [&]() { channel.enableReading(); });
         assert(channel.index() == 1);
         
         poller.updateChannel(&channel);  // 重复添加
@@ -306,8 +309,7 @@ void testEdgeCases() {
         assert(createSocketPair(fds) == 0);
         Channel channel(&loop, fds[0]);
         channel.set_index(kNew);
-        channel.enableReading();
-        poller.updateChannel(&channel);
+        updateOn(poller, channel, [&]() { channel.enableReading(); });
         assert(channel.index() == 1);
         
         poller.removeChannel(&channel);
@@ -364,14 +366,12 @@ void testEventTypes() {
     channel.set_index(kNew);
     // 测试EPOLLIN
     cout << "1. 测试EPOLLIN事件" << endl;
-    channel.enableReading();
-    poller.updateChannel(&channel);
+    updateOn(poller, channel, [&]() { channel.enableReading(); });
     assert((channel.events() & EPOLLIN) != 0);
     
     // 测试EPOLLOUT
     cout << "2. 测试EPOLLOUT事件" << endl;
-    channel.enableWriting();
-    poller.updateChannel(&channel);
+    updateOn(poller, channel, [&]() { channel.enableWriting(); });
     assert((channel.events() & EPOLLOUT) != 0);
     
     // 测试EPOLLIN | EPOLLOUT
@@ -380,15 +380,13 @@ void testEventTypes() {
     
     // 测试禁用读事件
     cout << "4. 测试禁用读事件" << endl;
-    channel.disableReading();
-    poller.updateChannel(&channel);
+    updateOn(poller, channel, [&]() { channel.disableReading(); });
     assert((channel.events() & EPOLLIN) == 0);
     assert((channel.events() & EPOLLOUT) != 0);
     
     // 测试禁用写事件
     cout << "5. 测试禁用写事件" << endl;
-    channel.disableWriting();
-    poller.updateChannel(&channel);
+    updateOn(poller, channel, [&]() { channel.disableWriting(); });
     assert((channel.events() & EPOLLIN) == 0);
     assert((channel.events() & EPOLLOUT) == 0);
     assert(channel.isNoneEvent());
@@ -2,15 +2,19 @@
 #include "./../EventLoop.h"
 #include "./../Channel.h"
 #include "./../Logger.h"
+#include "./../EventLoopThread.h"
 #include <iostream>
 #include <thread>
 #include <atomic>
 #include <chrono>
 #include <cassert>
+#include <future>
 #include <sys/socket.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <cstring>
+#include <vector>
+#include <string>
 
 using namespace std;
 
@@ -137,6 +141,151 @@ void testWakeupMechanism() {
     cout << "=== 测试5通过 ===\n" << endl;
 }
 
+// 测试6: 唤醒合并，loop处理任务期间的多次投递只写一次eventfd
+void testWakeupCoalescing() {
+    cout << "=== 测试6: 唤醒合并测试 ===" << endl;
+
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+
+    // 第一个任务阻塞loop，之后的投递都发生在loop处理完唤醒之前
+    promise<void> blocked;
+    promise<void> release;
+    shared_future<void> releaseFuture(release.get_future());
+    loop->queueInLoop([&blocked, releaseFuture]() {
+        blocked.set_value();
+        releaseFuture.wait();
+    });
+    blocked.get_future().wait();
+
+    const int NUM_TASKS = 1000;
+    uint64_t elidedBefore = loop->elidedWakeups();
+    atomic<int> executed{0};
+    promise<void> done;
+    for (int i = 0; i < NUM_TASKS; i++) {
+        loop->queueInLoop([&]() {
+            if (++executed == NUM_TASKS) {
+                done.set_value();
+            }
+        });
+    }
+    uint64_t elided = loop->elidedWakeups() - elidedBefore;
+    release.set_value();
+
+    assert(done.get_future().wait_for(chrono::seconds(1)) == future_status::ready);
+    cout << "   投递任务: " << NUM_TASKS << " 合并的唤醒: " << elided << endl;
+    // 只有第一次投递真正写了eventfd
+    assert(elided == NUM_TASKS - 1);
+
+    cout << "=== 测试6通过 ===\n" << endl;
+}
+
+// 测试7: 自适应忙轮询，事件间隔远大于自旋上限时预算降为0，只阻塞等待
+void testBusyPoll() {
+    cout << "=== 测试7: 忙轮询测试 ===" << endl;
+
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+    const int MAX_SPIN_US = 200;
+    promise<void> configured;
+    loop->runInLoop([&]() {
+        loop->setBusyPoll(MAX_SPIN_US);
+        configured.set_value();
+    });
+    configured.get_future().wait();
+    assert(loop->spinBudgetUs() == MAX_SPIN_US);
+
+    // 连续投递：自旋期间就能收到任务
+    atomic<int> executed{0};
+    for (int i = 0; i < 100; i++) {
+        loop->queueInLoop([&executed]() { executed++; });
+    }
+    while (executed < 100) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    cout << "   自旋poll: " << loop->spinPolls() << " 阻塞poll: " << loop->blockingPolls() << endl;
+    assert(loop->spinPolls() > 0);
+
+    // 20ms一次的稀疏事件：平均间隔超过上限，预算降为0
+    for (int i = 0; i < 10; i++) {
+        this_thread::sleep_for(chrono::milliseconds(20));
+        loop->queueInLoop([]() {});
+    }
+    this_thread::sleep_for(chrono::milliseconds(20));
+    cout << "   稀疏事件后的自旋预算: " << loop->spinBudgetUs() << "us" << endl;
+    assert(loop->spinBudgetUs() == 0);
+    uint64_t spins = loop->spinPolls();
+    loop->queueInLoop([]() {});
+    this_thread::sleep_for(chrono::milliseconds(20));
+    assert(loop->spinPolls() == spins);
+
+    cout << "=== 测试7通过 ===\n" << endl;
+}
+
+// 测试8: 任务优先级与后台任务预算
+void testPriorityLanes() {
+    cout << "=== 测试8: 任务优先级测试 ===" << endl;
+
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+    const int BACKGROUND_TASKS = 100;
+    const int MAX_TASKS = 10;
+    promise<void> configured;
+    loop->runInLoop([&]() {
+        loop->setBackgroundBudget(MAX_TASKS, 1000 * 1000);
+        configured.set_value();
+    });
+    configured.get_future().wait();
+
+    // 先阻塞loop，让各种优先级的任务在同一轮中被取出
+    promise<void> blocked;
+    promise<void> release;
+    loop->runInLoop([&]() {
+        blocked.set_value();
+        release.get_future().wait();
+    });
+    blocked.get_future().wait();
+
+    // 只在loop线程中修改
+    vector<string> order;
+    loop->queueInLoop([&order]() { order.push_back("normal1"); });
+    for (int i = 0; i < BACKGROUND_TASKS; i++) {
+        loop->queueInLoop([&order]() {
+            this_thread::sleep_for(chrono::milliseconds(1));
+            order.push_back("background");
+        }, EventLoop::kBackground);
+    }
+    loop->queueInLoop([&order]() { order.push_back("urgent"); }, EventLoop::kUrgent);
+    loop->queueInLoop([&order]() { order.push_back("normal2"); });
+    uint64_t iterations = loop->stats().iterations;
+    release.set_value();
+
+    // 后台任务执行期间投递的普通任务不需要等积压的后台任务全部执行完
+    promise<size_t> normalSeen;
+    this_thread::sleep_for(chrono::milliseconds(20));
+    loop->queueInLoop([&]() { normalSeen.set_value(order.size()); });
+    size_t seenAt = normalSeen.get_future().get();
+
+    promise<void> done;
+    loop->queueInLoop([&]() { done.set_value(); }, EventLoop::kBackground);
+    done.get_future().wait();
+
+    assert(order.size() == static_cast<size_t>(BACKGROUND_TASKS + 3));
+    assert(order[0] == "urgent");
+    assert(order[1] == "normal1");
+    assert(order[2] == "normal2");
+    for (size_t i = 3; i < order.size(); i++) {
+        assert(order[i] == "background");
+    }
+    // 每轮最多执行MAX_TASKS个后台任务，分散到多轮中执行
+    uint64_t rounds = loop->stats().iterations - iterations;
+    cout << "   后台任务分散到 " << rounds << " 轮，普通任务执行时已完成 " << seenAt << " 个任务" << endl;
+    assert(rounds >= BACKGROUND_TASKS / MAX_TASKS);
+    assert(seenAt < order.size());
+
+    cout << "=== 测试8通过 ===\n" << endl;
+}
+
 // 主测试函数
 int main() {
     cout << "开始 EventLoop 测试套件\n" << endl;
@@ -145,6 +294,9 @@ int main() {
         testBasicFunctionality();           // 基本功能
         testSingleEventLoopLifecycle();     // 完整生命周期
         testWakeupMechanism();              // 唤醒机制
+        testWakeupCoalescing();             // 唤醒合并
+        testBusyPoll();                     // 忙轮询
+        testPriorityLanes();                // 任务优先级
         
         cout << string(60, '=') << endl;
         cout << "🎉 所有 EventLoop 测试通过！" << endl;
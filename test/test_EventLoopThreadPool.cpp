@@ -6,6 +6,12 @@
 #include <chrono>
 #include <atomic>
 #include <cassert>
+#include <future>
+#include <set>
+#include <vector>
+#include <string>
+#include <pthread.h>
+#include <sched.h>
 
 // 辅助函数：打印线程ID
 void printThreadId(const std::string& name, EventLoop* loop = nullptr) {
@@ -147,6 +153,145 @@ void testDestruction() {
 }
 
 
+// 测试6：负载感知的分配策略，负载数据直接通过EventLoop的统计接口构造
+void testDispatchPolicies() {
+    std::cout << "=== Test 6: Dispatch Policies ===" << std::endl;
+
+    EventLoop baseLoop;
+    EventLoopThreadPool pool(&baseLoop, "DispatchPool");
+    pool.setThreadNum(4);
+    pool.start();
+    std::vector<EventLoop*> loops = pool.getAllLoops();
+
+    // 链接数最少：loop2没有链接
+    loops[0]->addConnectionCount(5);
+    loops[1]->addConnectionCount(3);
+    loops[3]->addConnectionCount(1);
+    pool.setDispatchPolicy(EventLoopThreadPool::DispatchPolicy::kLeastConnections);
+    assert(pool.getNextLoop() == loops[2]);
+    loops[2]->addConnectionCount(2);
+    assert(pool.getNextLoop() == loops[3]);
+
+    // 缓冲区积压最少
+    loops[0]->addBufferedBytes(100);
+    loops[1]->addBufferedBytes(10);
+    loops[2]->addBufferedBytes(1000);
+    loops[3]->addBufferedBytes(500);
+    pool.setDispatchPolicy(EventLoopThreadPool::DispatchPolicy::kLeastBufferedBytes);
+    assert(pool.getNextLoop() == loops[1]);
+
+    // 负载相同时轮流分配，不会全部落到第一个loop
+    for (EventLoop* loop : loops) {
+        loop->addBufferedBytes(-loop->bufferedBytes());
+    }
+    std::set<EventLoop*> picked;
+    for (size_t i = 0; i < loops.size(); ++i) {
+        picked.insert(pool.getNextLoop());
+    }
+    assert(picked.size() == loops.size());
+
+    // 随机两选一：从不选择两个中链接数多的那个，所以链接数最多的loop永远不会被选中
+    loops[0]->addConnectionCount(100);
+    pool.setDispatchPolicy(EventLoopThreadPool::DispatchPolicy::kPowerOfTwoChoices);
+    for (int i = 0; i < 100; ++i) {
+        assert(pool.getNextLoop() != loops[0]);
+    }
+
+    // 最近忙碌时间最少：让loop1忙碌一段时间
+    std::promise<void> done;
+    loops[1]->runInLoop([&done]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        done.set_value();
+    });
+    done.get_future().wait();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    pool.setDispatchPolicy(EventLoopThreadPool::DispatchPolicy::kLeastBusyTime);
+    for (size_t i = 0; i < loops.size(); ++i) {
+        assert(pool.getNextLoop() != loops[1]);
+    }
+
+    // 一个采样窗口内的突发链接：每次分配都预先记上一个链接的开销，不会全部落到最闲的loop上
+    for (EventLoop* loop : loops) {
+        loop->addConnectionCount(-loop->connectionCount());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(110));
+    for (size_t i = 0; i < loops.size(); ++i) {
+        std::promise<void> busy;
+        loops[i]->runInLoop([&busy, i]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5 * (i + 1)));
+            busy.set_value();
+        });
+        busy.get_future().wait();
+    }
+    std::set<EventLoop*> burst;
+    for (size_t i = 0; i < loops.size(); ++i) {
+        burst.insert(pool.getNextLoop());
+    }
+    assert(burst.size() == loops.size());
+
+    std::cout << "Test 6 passed!" << std::endl << std::endl;
+}
+
+
+// 测试7：线程命名、绑核，以及线程初始化回调在每个子loop中执行
+void testPlacement() {
+    std::cout << "=== Test 7: Thread Placement ===" << std::endl;
+
+    EventLoop baseLoop;
+    EventLoopThreadPool pool(&baseLoop, "PlacePool");
+    pool.setThreadNum(2);
+    pool.setCpuAffinity({0});
+    std::atomic<int> initCount{0};
+    pool.start([&initCount](EventLoop*) { ++initCount; });
+    assert(initCount == 2);
+
+    std::vector<EventLoop*> loops = pool.getAllLoops();
+    for (size_t i = 0; i < loops.size(); ++i) {
+        std::promise<std::pair<std::string, bool>> result;
+        loops[i]->runInLoop([&result]() {
+            char name[16] = {0};
+            pthread_getname_np(pthread_self(), name, sizeof(name));
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+            result.set_value({name, CPU_COUNT(&cpus) == 1 && CPU_ISSET(0, &cpus)});
+        });
+        auto r = result.get_future().get();
+        std::cout << "Loop " << i << " thread name: " << r.first << std::endl;
+        assert(r.first == "PlacePool" + std::to_string(i));
+        assert(r.second);
+    }
+
+    std::cout << "Test 7 passed!" << std::endl << std::endl;
+}
+
+
+// 测试8：启动耗时基准，所有线程并行创建EventLoop，启动时间不应该随线程数线性增长
+void testStartupTime() {
+    std::cout << "=== Test 8: Startup Time ===" << std::endl;
+
+    const int threadCounts[] = {1, 8, 32};
+    for (int n : threadCounts) {
+        EventLoop baseLoop;
+        EventLoopThreadPool pool(&baseLoop, "StartPool");
+        pool.setThreadNum(n);
+        auto begin = std::chrono::steady_clock::now();
+        pool.start();
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - begin).count();
+        std::cout << n << " threads started in " << us << " us" << std::endl;
+
+        std::vector<EventLoop*> loops = pool.getAllLoops();
+        assert(static_cast<int>(loops.size()) == n);
+        assert(std::set<EventLoop*>(loops.begin(), loops.end()).size() == static_cast<size_t>(n));
+        // 以前每个线程固定sleep(1)，这里留足余量只抓住这类回退
+        assert(us < 1000 * 1000);
+    }
+
+    std::cout << "Test 8 passed!" << std::endl << std::endl;
+}
+
+
 // 主测试函数
 int main() {
     std::cout << "Starting EventLoopThreadPool tests..." << std::endl;
@@ -156,6 +301,9 @@ int main() {
         testSingleThreadMode();
         testConcurrentAccess();
         testDestruction();
+        testDispatchPolicies();
+        testPlacement();
+        testStartupTime();
         
         std::cout << "========================================" << std::endl;
         std::cout << "All tests completed successfully!" << std::endl;
@@ -0,0 +1,129 @@
+#include "./../InplaceFunction.h"
+#include "./../EventLoop.h"
+#include "./../EventLoopThread.h"
+#include <iostream>
+#include <memory>
+#include <string>
+#include <future>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+// 统计operator new的调用次数，验证内联存储不分配堆内存
+static size_t g_allocations = 0;
+
+void* operator new(size_t size) {
+    ++g_allocations;
+    if (void* p = malloc(size)) {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+struct Counter {
+    int value = 0;
+    void add(int n) { value += n; }
+};
+
+// 测试1: 小对象直接保存在内部，构造、移动、调用都不分配内存
+void testInline() {
+    cout << "=== 测试1: 内联存储 ===" << endl;
+
+    auto owner = make_shared<Counter>();
+    size_t before = g_allocations;
+    InplaceFunction<void(int)> f(bind(&Counter::add, owner, placeholders::_1));
+    InplaceFunction<void(int)> g(std::move(f));
+    g(3);
+    g(4);
+    assert(g_allocations == before);
+    assert(!f);
+    assert(owner->value == 7);
+
+    // 成员函数指针直接调用
+    InplaceFunction<void(Counter&, int)> h(&Counter::add);
+    h(*owner, 1);
+    assert(owner->value == 8);
+
+    cout << "=== 测试1通过 ===\n" << endl;
+}
+
+// 测试2: 超过内联大小的对象退回到堆上，移动时只转移指针
+void testHeapFallback() {
+    cout << "=== 测试2: 堆上存储 ===" << endl;
+
+    struct Big {
+        char data[128];
+        int operator()() const { return data[0] + data[127]; }
+    };
+    Big big{};
+    big.data[0] = 1;
+    big.data[127] = 2;
+
+    size_t before = g_allocations;
+    InplaceFunction<int()> f(big);
+    assert(g_allocations == before + 1);
+    InplaceFunction<int()> g;
+    g = std::move(f);
+    assert(g_allocations == before + 1);
+    assert(g() == 3);
+
+    cout << "=== 测试2通过 ===\n" << endl;
+}
+
+// 测试3: 可以保存只能移动的对象，析构时释放它持有的资源
+void testMoveOnly() {
+    cout << "=== 测试3: 只能移动的可调用对象 ===" << endl;
+
+    auto resource = make_shared<int>(42);
+    weak_ptr<int> weak(resource);
+    {
+        unique_ptr<int> p(new int(1));
+        InplaceFunction<int()> f([p = std::move(p), resource = std::move(resource)]() { return *p + *resource; });
+        assert(f() == 43);
+        f = nullptr;
+        assert(!f);
+        assert(weak.expired());
+    }
+
+    // 空的函数指针和std::function构造出空的回调
+    void (*nullFunc)() = nullptr;
+    InplaceFunction<void()> empty1(nullFunc);
+    InplaceFunction<void()> empty2(function<void()>{});
+    assert(!empty1 && !empty2);
+
+    cout << "=== 测试3通过 ===\n" << endl;
+}
+
+// 测试4: 跨线程投递只能移动的任务
+void testQueueInLoop() {
+    cout << "=== 测试4: 投递只能移动的任务 ===" << endl;
+
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+
+    promise<string> result;
+    future<string> f = result.get_future();
+    loop->queueInLoop([result = std::move(result)]() mutable { result.set_value("done"); });
+    assert(f.get() == "done");
+
+    cout << "=== 测试4通过 ===\n" << endl;
+}
+
+int main() {
+    cout << "开始 InplaceFunction 测试套件\n" << endl;
+
+    testInline();
+    testHeapFallback();
+    testMoveOnly();
+    testQueueInLoop();
+
+    cout << string(60, '=') << endl;
+    cout << "🎉 所有 InplaceFunction 测试通过！" << endl;
+    cout << string(60, '=') << endl;
+    return 0;
+}
@@ -0,0 +1,346 @@
+#include "./../EventLoop.h"
+#include "./../EventLoopThread.h"
+#include "./../Channel.h"
+#include "./../TcpConnection.h"
+#include <iostream>
+#include <future>
+#include <cassert>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+// 测试1: 水平触发语义，每次回调只读1字节，数据没读完会继续通知
+void testLevelTriggered() {
+    cout << "=== 测试1: 水平触发 ===" << endl;
+
+    EventLoop loop;
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == 0);
+
+    Channel channel(&loop, fds[0]);
+    int reads = 0;
+    channel.setReadCallback([&](Timestamp) {
+        char c;
+        if (read(fds[0], &c, 1) == 1) {
+            ++reads;
+        }
+    });
+    channel.enableReading();
+    assert(write(fds[1], "abcdef", 6) == 6);
+
+    loop.runAfter(0.2, [&]() { loop.quit(); });
+    loop.loop();
+
+    cout << "   读回调次数: " << reads << endl;
+    assert(reads == 6);
+
+    channel.disableAll();
+    channel.remove();
+    close(fds[0]);
+    close(fds[1]);
+
+    cout << "=== 测试1通过 ===\n" << endl;
+}
+
+// 测试2: enableWriting/disableWriting/disableAll在同一个请求上修改事件
+void testModifyEvents() {
+    cout << "=== 测试2: 修改监听事件 ===" << endl;
+
+    EventLoop loop;
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == 0);
+
+    Channel channel(&loop, fds[0]);
+    int writes = 0;
+    int reads = 0;
+    channel.setWriteCallback([&]() {
+        // 可写事件一直就绪，第3次后停止监听写
+        if (++writes == 3) {
+            channel.disableWriting();
+        }
+    });
+    channel.setReadCallback([&](Timestamp) {
+        char buf[16];
+        reads += read(fds[0], buf, sizeof(buf)) > 0 ? 1 : 0;
+    });
+    channel.enableReading();
+    channel.enableWriting();
+
+    loop.runAfter(0.1, [&]() {
+        // 禁用所有事件后，再到达的数据不会通知
+        channel.disableAll();
+        assert(write(fds[1], "x", 1) == 1);
+    });
+    loop.runAfter(0.2, [&]() {
+        // 重新启用后水平触发，之前到达的数据会通知
+        assert(reads == 0);
+        channel.enableReading();
+    });
+    loop.runAfter(0.3, [&]() { loop.quit(); });
+    loop.loop();
+
+    cout << "   写回调次数: " << writes << " 读回调次数: " << reads << endl;
+    assert(writes == 3);
+    assert(reads == 1);
+
+    channel.disableAll();
+    channel.remove();
+    close(fds[0]);
+    close(fds[1]);
+
+    cout << "=== 测试2通过 ===\n" << endl;
+}
+
+// 测试3: TcpConnection在io_uring后端上收发数据
+void testTcpConnectionEcho() {
+    cout << "=== 测试3: TcpConnection回显 ===" << endl;
+
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    InetAddress local("127.0.0.1", 0);
+    InetAddress peer("127.0.0.1", 0);
+    auto conn = make_shared<TcpConnection>(loop, string("uringtest"), fds[0], local, peer);
+
+    promise<void> connected;
+    conn->setConnectionCallback([&](const TcpConnectionPtr& c) {
+        if (c->connected()) {
+            connected.set_value();
+        }
+    });
+    conn->setMessageCallback([](const TcpConnectionPtr& c, Buffer* buf, Timestamp) {
+        c->send(buf->retrieveAllAsString());
+    });
+    // 必须在loop线程中建立链接：io_uring的提交队列不是线程安全的
+    loop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
+    assert(connected.get_future().wait_for(chrono::seconds(1)) == future_status::ready);
+
+    const string msg = "hello io_uring";
+    assert(write(fds[1], msg.data(), msg.size()) == static_cast<ssize_t>(msg.size()));
+    string echoed;
+    while (echoed.size() < msg.size()) {
+        char buf[64];
+        ssize_t n = read(fds[1], buf, sizeof(buf));
+        assert(n > 0);
+        echoed.append(buf, n);
+    }
+    assert(echoed == msg);
+
+    conn->setConnectionCallback([](const TcpConnectionPtr&) {});
+    promise<void> destroyed;
+    loop->runInLoop([&]() {
+        conn->connectDestroyed();
+        destroyed.set_value();
+    });
+    destroyed.get_future().wait();
+    close(fds[1]);
+
+    cout << "=== 测试3通过 ===\n" << endl;
+}
+
+// 测试4: 完成模式回显大块数据，覆盖部分发送、缓冲区环复用与对端关闭
+void testCompletionIoEcho() {
+    cout << "=== 测试4: 完成模式回显 ===" << endl;
+
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+    assert(loop->ioUringPoller() != nullptr);
+
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    InetAddress local("127.0.0.1", 0);
+    InetAddress peer("127.0.0.1", 0);
+    auto conn = make_shared<TcpConnection>(loop, string("uringcompletion"), fds[0], local, peer);
+    conn->setCompletionIo(true);
+
+    promise<void> connected;
+    promise<void> closed;
+    conn->setConnectionCallback([&](const TcpConnectionPtr& c) {
+        if (c->connected()) {
+            connected.set_value();
+        }
+    });
+    conn->setMessageCallback([](const TcpConnectionPtr& c, Buffer* buf, Timestamp) {
+        c->send(buf->retrieveAllAsString());
+    });
+    conn->setCloseCallback([&](const TcpConnectionPtr& c) { closed.set_value(); });
+    loop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
+    assert(connected.get_future().wait_for(chrono::seconds(1)) == future_status::ready);
+
+    // 1MB数据：超过socket缓冲区，需要多次recv/send
+    const size_t total = 1024 * 1024;
+    string msg(total, '\0');
+    for (size_t i = 0; i < total; ++i) {
+        msg[i] = static_cast<char>('a' + i % 26);
+    }
+    thread writer([&]() {
+        size_t written = 0;
+        while (written < total) {
+            ssize_t n = write(fds[1], msg.data() + written, total - written);
+            assert(n > 0);
+            written += n;
+        }
+    });
+    string echoed;
+    while (echoed.size() < total) {
+        char buf[65536];
+        ssize_t n = read(fds[1], buf, sizeof(buf));
+        assert(n > 0);
+        echoed.append(buf, n);
+    }
+    writer.join();
+    cout << "   回显字节数: " << echoed.size() << endl;
+    assert(echoed == msg);
+
+    // 对端关闭：recv完成事件返回0，走handleClose
+    shutdown(fds[1], SHUT_WR);
+    assert(closed.get_future().wait_for(chrono::seconds(1)) == future_status::ready);
+    assert(!conn->connected());
+
+    promise<void> destroyed;
+    loop->runInLoop([&]() {
+        conn->connectDestroyed();
+        destroyed.set_value();
+    });
+    destroyed.get_future().wait();
+    close(fds[1]);
+
+    cout << "=== 测试4通过 ===\n" << endl;
+}
+
+// 测试5: 完成模式的链接只被未完成的操作持有，loop析构时在时间轮、内存池之前释放
+void testCompletionOutlivesLoop() {
+    cout << "=== 测试5: loop析构时释放完成模式的链接 ===" << endl;
+
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    weak_ptr<TcpConnection> weakConn;
+    {
+        EventLoopThread loopThread;
+        EventLoop* loop = loopThread.startLoop();
+        InetAddress local("127.0.0.1", 0);
+        InetAddress peer("127.0.0.1", 0);
+        auto conn = make_shared<TcpConnection>(loop, string("uringteardown"), fds[0], local, peer);
+        conn->setCompletionIo(true);
+        conn->setConnectionCallback([](const TcpConnectionPtr&) {});
+        promise<void> received;
+        // 不取走数据：析构时输入缓冲区还持有内存池的存储
+        conn->setMessageCallback([&](const TcpConnectionPtr&, Buffer*, Timestamp) { received.set_value(); });
+        loop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
+        conn->setIdleTimeout(60);
+        assert(write(fds[1], "hello", 5) == 5);
+        assert(received.get_future().wait_for(chrono::seconds(1)) == future_status::ready);
+        weakConn = conn;
+        conn.reset();
+        assert(!weakConn.expired());
+    }
+    // loop线程退出，链接随被取消的recv操作一起释放
+    assert(weakConn.expired());
+    close(fds[1]);
+
+    cout << "=== 测试5通过 ===\n" << endl;
+}
+
+// 测试6: 完成模式下在两次发送之间shutdown，等两个缓冲区都发完再关闭写端
+void testShutdownBetweenSends() {
+    cout << "=== 测试6: 发送间隙中shutdown ===" << endl;
+
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    InetAddress local("127.0.0.1", 0);
+    InetAddress peer("127.0.0.1", 0);
+    auto conn = make_shared<TcpConnection>(loop, string("uringshutdown"), fds[0], local, peer);
+    conn->setCompletionIo(true);
+
+    const size_t total = 1024 * 1024;
+    promise<void> connected;
+    conn->setConnectionCallback([&](const TcpConnectionPtr& c) {
+        if (c->connected()) {
+            c->send(string(total, 'z'));
+            connected.set_value();
+        }
+    });
+    // 收到对端的消息就shutdown：recv和send在同一轮完成时，sendOp_已经清零、下一个块还没有提交
+    conn->setMessageCallback([](const TcpConnectionPtr& c, Buffer* buf, Timestamp) {
+        buf->retrieveAll();
+        c->shutdown();
+    });
+    conn->setCloseCallback([](const TcpConnectionPtr&) {});
+    loop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
+    assert(connected.get_future().wait_for(chrono::seconds(1)) == future_status::ready);
+
+    size_t received = 0;
+    char buf[65536];
+    while (received < 64 * 1024) {
+        ssize_t n = read(fds[1], buf, sizeof(buf));
+        assert(n > 0);
+        received += n;
+    }
+    // loop忙的时候对端发消息并腾出接收空间，让recv和send的完成事件在同一轮返回
+    promise<void> busy;
+    promise<void> release;
+    shared_future<void> released = release.get_future().share();
+    loop->runInLoop([&busy, released]() {
+        busy.set_value();
+        released.wait();
+    });
+    busy.get_future().wait();
+    assert(write(fds[1], "bye", 3) == 3);
+    // 只读已经到达的数据：loop忙的时候不会提交新的块
+    for (int i = 0; i < 5; ++i) {
+        ssize_t n = 0;
+        while ((n = recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+            received += n;
+        }
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    release.set_value();
+
+    while (true) {
+        ssize_t n = read(fds[1], buf, sizeof(buf));
+        assert(n >= 0);
+        if (n == 0) {
+            break;
+        }
+        received += n;
+    }
+    cout << "   关闭写端前收到的字节数: " << received << endl;
+    assert(received == total);
+
+    promise<void> destroyed;
+    loop->runInLoop([&]() {
+        conn->connectDestroyed();
+        destroyed.set_value();
+    });
+    destroyed.get_future().wait();
+    close(fds[1]);
+
+    cout << "=== 测试6通过 ===\n" << endl;
+}
+
+int main() {
+    cout << "开始 IoUringPoller 测试套件\n" << endl;
+    setenv("MUDUO_USE_IOURING", "1", 1);
+
+    testLevelTriggered();
+    testModifyEvents();
+    testTcpConnectionEcho();
+    testCompletionIoEcho();
+    testCompletionOutlivesLoop();
+    testShutdownBetweenSends();
+
+    cout << string(60, '=') << endl;
+    cout << "🎉 所有 IoUringPoller 测试通过！" << endl;
+    cout << string(60, '=') << endl;
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include "./../LoopStats.h"
+#include "./../EventLoop.h"
+#include "./../EventLoopThread.h"
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <future>
+#include <vector>
+#include <cassert>
+
+using namespace std;
+
+// 测试1: 直方图的分桶和百分位
+void testHistogram() {
+    cout << "=== 测试1: 对数线性直方图 ===" << endl;
+
+    // 每个值都落在自己的桶内，桶号单调不减，上界误差不超过25%
+    int last = 0;
+    for (uint64_t v = 0; v < 100000; ++v) {
+        int idx = Histogram::bucketIndex(v);
+        assert(idx >= last && idx < Histogram::kBuckets);
+        assert(Histogram::bucketUpperBound(idx) >= v);
+        assert(idx == 0 || Histogram::bucketUpperBound(idx - 1) < v);
+        assert(Histogram::bucketUpperBound(idx) <= v + v / 4 + 1);
+        last = idx;
+    }
+    assert(Histogram::bucketIndex(UINT64_MAX) == Histogram::kBuckets - 1);
+    assert(Histogram::bucketUpperBound(Histogram::kBuckets - 1) == UINT64_MAX);
+
+    Histogram hist;
+    for (uint64_t v = 1; v <= 1000; ++v) {
+        hist.record(v);
+    }
+    Histogram::Snapshot snap = hist.snapshot();
+    assert(snap.count == 1000);
+    assert(snap.sum == 500500);
+    assert(snap.max == 1000);
+    assert(snap.percentile(50) >= 500 && snap.percentile(50) <= 625);
+    assert(snap.percentile(99) >= 990 && snap.percentile(99) <= 1000);
+    assert(snap.percentile(100) == 1000);
+    cout << "   p50=" << snap.percentile(50) << " p99=" << snap.percentile(99) << " mean=" << snap.mean() << endl;
+
+    cout << "=== 测试1通过 ===\n" << endl;
+}
+
+// 测试2: EventLoop在运行中统计唤醒、任务、队列深度和忙碌时间，其他线程读取快照
+void testLoopStats() {
+    cout << "=== 测试2: EventLoop运行统计 ===" << endl;
+
+    EventLoopThread thread;
+    EventLoop* loop = thread.startLoop();
+
+    // 阻塞loop，让随后投递的任务在队列中堆积，醒来后一轮全部取出
+    promise<void> blocked;
+    promise<void> release;
+    loop->runInLoop([&]() {
+        blocked.set_value();
+        release.get_future().wait();
+    });
+    blocked.get_future().wait();
+    constexpr int kTasks = 100;
+    for (int i = 0; i < kTasks; ++i) {
+        loop->queueInLoop([]() {});
+    }
+    // 一个执行较慢的任务
+    loop->queueInLoop([]() { this_thread::sleep_for(chrono::milliseconds(20)); });
+    release.set_value();
+
+    promise<void> done;
+    loop->queueInLoop([&]() { done.set_value(); });
+    done.get_future().wait();
+    // 统计在一轮结束时才记录：再往返一次，保证上面那一轮已经记录完
+    promise<void> settled;
+    loop->queueInLoop([&]() { settled.set_value(); });
+    settled.get_future().wait();
+
+    LoopStatsSnapshot stats = loop->stats();
+    cout << "   " << stats.toString() << endl;
+    assert(stats.iterations >= 2);
+    assert(stats.wakeups >= 2);
+    assert(stats.functors >= kTasks + 2);
+    assert(stats.queueDepth.max >= kTasks);
+    assert(stats.functorUs.max >= 20 * 1000);
+    assert(stats.busyUs >= 20 * 1000);
+    assert(stats.pollBatch.count == stats.iterations);
+    assert(stats.pollWaitUs.count == stats.iterations);
+    assert(loop->totalBusyUs() >= stats.busyUs);
+
+    cout << "=== 测试2通过 ===\n" << endl;
+}
+
+int main() {
+    cout << "开始 LoopStats 测试套件\n" << endl;
+
+    testHistogram();
+    testLoopStats();
+
+    cout << string(60, '=') << endl;
+    cout << "🎉 所有 LoopStats 测试通过！" << endl;
+    cout << string(60, '=') << endl;
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include "./../LoopWatchdog.h"
+#include "./../EventLoop.h"
+#include "./../EventLoopThread.h"
+#include "./../Channel.h"
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <vector>
+#include <cassert>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+// 收集watchdog线程和loop线程的报告
+struct StallCollector {
+    mutex mtx;
+    vector<LoopStall> stalls;
+
+    LoopWatchdog::StallCallback callback() {
+        return [this](const LoopStall& stall) {
+            cout << "   报告: " << stall.toString() << endl;
+            lock_guard<mutex> lock(mtx);
+            stalls.push_back(stall);
+        };
+    }
+    vector<LoopStall> take() {
+        lock_guard<mutex> lock(mtx);
+        vector<LoopStall> result;
+        result.swap(stalls);
+        return result;
+    }
+};
+
+// 在loop线程中执行一次任务并等待完成
+static void runSync(EventLoop* loop, function<void()> f) {
+    promise<void> done;
+    loop->runInLoop([&]() { f(); done.set_value(); });
+    done.get_future().wait();
+}
+
+// 测试1: 慢任务在执行过程中被watchdog发现，结束后loop再报告一次
+void testSlowFunctor() {
+    cout << "=== 测试1: 慢任务 ===" << endl;
+
+    EventLoopThread thread;
+    EventLoop* loop = thread.startLoop();
+    StallCollector collector;
+    LoopWatchdog watchdog(50, 10);
+    watchdog.setStallCallback(collector.callback());
+    watchdog.watch(loop);
+    watchdog.start();
+    // 等待检测在loop线程中打开
+    runSync(loop, []() {});
+
+    runSync(loop, []() { this_thread::sleep_for(chrono::milliseconds(300)); });
+    // 慢任务返回之后loop线程才报告，往返一次保证报告已经发出
+    runSync(loop, []() {});
+    vector<LoopStall> stalls = collector.take();
+    assert(stalls.size() == 2);
+    assert(!stalls[0].finished);
+    assert(stalls[0].loop == loop);
+    assert(stalls[0].activity == LoopActivity::kFunctor);
+    assert(stalls[0].fd == -1);
+    assert(stalls[0].elapsedUs >= 50 * 1000 && stalls[0].elapsedUs < 300 * 1000);
+    assert(stalls[1].finished);
+    assert(stalls[1].elapsedUs >= 300 * 1000);
+    assert(watchdog.stalls() == 2);
+
+    cout << "=== 测试1通过 ===\n" << endl;
+}
+
+// 测试2: 慢的读回调报告fd、回调类型以及channel名字
+void testSlowReadCallback() {
+    cout << "=== 测试2: 慢的读回调 ===" << endl;
+
+    EventLoopThread thread;
+    EventLoop* loop = thread.startLoop();
+    StallCollector collector;
+    LoopWatchdog watchdog(50, 10);
+    watchdog.setStallCallback(collector.callback());
+    watchdog.watch(loop);
+    watchdog.start();
+
+    int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    Channel channel(loop, fd);
+    channel.setName("conn-slow");
+    promise<void> handled;
+    channel.setReadCallback([&](Timestamp) {
+        uint64_t value = 0;
+        ::read(fd, &value, sizeof(value));
+        this_thread::sleep_for(chrono::milliseconds(200));
+        handled.set_value();
+    });
+    runSync(loop, [&]() { channel.enableReading(); });
+
+    uint64_t one = 1;
+    ::write(fd, &one, sizeof(one));
+    handled.get_future().wait();
+    // 读回调之后的结束报告和下一轮的任务都在loop线程中，往返一次保证报告已经发出
+    runSync(loop, [&]() {
+        channel.disableAll();
+        channel.remove();
+    });
+    ::close(fd);
+
+    vector<LoopStall> stalls = collector.take();
+    assert(stalls.size() == 2);
+    assert(!stalls[0].finished);
+    assert(stalls[0].activity == LoopActivity::kRead);
+    assert(stalls[0].fd == fd);
+    assert(stalls[1].finished);
+    assert(stalls[1].activity == LoopActivity::kRead);
+    assert(stalls[1].fd == fd);
+    assert(stalls[1].name == "conn-slow");
+
+    cout << "=== 测试2通过 ===\n" << endl;
+}
+
+// 测试3: 快速的回调和没有被监控的loop不报告
+void testNoFalsePositive() {
+    cout << "=== 测试3: 没有误报 ===" << endl;
+
+    EventLoopThread watchedThread;
+    EventLoopThread otherThread;
+    EventLoop* watched = watchedThread.startLoop();
+    EventLoop* other = otherThread.startLoop();
+    StallCollector collector;
+    LoopWatchdog watchdog(50, 10);
+    watchdog.setStallCallback(collector.callback());
+    watchdog.watch(watched);
+    watchdog.start();
+
+    for (int i = 0; i < 1000; ++i) {
+        watched->queueInLoop([]() {});
+    }
+    runSync(watched, []() {});
+    runSync(other, []() { this_thread::sleep_for(chrono::milliseconds(100)); });
+    // 空闲阻塞在poll中也不是卡顿
+    this_thread::sleep_for(chrono::milliseconds(100));
+    assert(collector.take().empty());
+    assert(watchdog.stalls() == 0);
+
+    cout << "=== 测试3通过 ===\n" << endl;
+}
+
+int main() {
+    cout << "开始 LoopWatchdog 测试套件\n" << endl;
+
+    testSlowFunctor();
+    testSlowReadCallback();
+    testNoFalsePositive();
+
+    cout << string(60, '=') << endl;
+    cout << "🎉 所有 LoopWatchdog 测试通过！" << endl;
+    cout << string(60, '=') << endl;
+    return 0;
+}
@@ -0,0 +1,181 @@
+#include "./../MpscQueue.h"
+#include "./../EventLoop.h"
+#include "./../EventLoopThread.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <future>
+#include <atomic>
+#include <cassert>
+#include <memory>
+
+using namespace std;
+
+// 测试1: 单线程下先进先出
+void testFifo() {
+    cout << "=== 测试1: 先进先出 ===" << endl;
+
+    MpscQueue<int> queue;
+    assert(queue.empty());
+    for (int i = 0; i < 100; ++i) {
+        queue.push(i);
+    }
+    int value = -1;
+    for (int i = 0; i < 100; ++i) {
+        assert(queue.pop(value));
+        assert(value == i);
+    }
+    assert(!queue.pop(value));
+    assert(queue.empty());
+
+    cout << "=== 测试1通过 ===\n" << endl;
+}
+
+// 测试2: 多个生产者并发push，消费者同时pop，每个生产者的顺序保持不变且不丢不重
+void testMultiProducer() {
+    cout << "=== 测试2: 多生产者 ===" << endl;
+
+    constexpr int kProducers = 8;
+    constexpr int kPerProducer = 100000;
+    MpscQueue<pair<int, int>> queue;
+
+    vector<thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&queue, p]() {
+            for (int i = 0; i < kPerProducer; ++i) {
+                queue.push({p, i});
+            }
+        });
+    }
+
+    vector<int> next(kProducers, 0);
+    int total = 0;
+    pair<int, int> item;
+    while (total < kProducers * kPerProducer) {
+        if (queue.pop(item)) {
+            assert(item.second == next[item.first]);
+            ++next[item.first];
+            ++total;
+        }
+    }
+    for (auto& t : producers) {
+        t.join();
+    }
+    assert(queue.empty());
+
+    cout << "   取出任务数: " << total << endl;
+    cout << "=== 测试2通过 ===\n" << endl;
+}
+
+// 测试3: 多个线程向同一个loop投递任务，全部执行且在loop线程中执行
+void testQueueInLoop() {
+    cout << "=== 测试3: 多线程queueInLoop ===" << endl;
+
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 10000;
+    atomic<int> executed{0};
+    atomic<bool> wrongThread{false};
+    promise<void> done;
+
+    vector<thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < kPerThread; ++i) {
+                loop->queueInLoop([&]() {
+                    if (!loop->isInLoopThread()) {
+                        wrongThread = true;
+                    }
+                    if (++executed == kThreads * kPerThread) {
+                        done.set_value();
+                    }
+                });
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    assert(done.get_future().wait_for(chrono::seconds(5)) == future_status::ready);
+    assert(!wrongThread);
+
+    cout << "   执行任务数: " << executed << endl;
+    cout << "=== 测试3通过 ===\n" << endl;
+}
+
+// 测试4: 节点循环使用，稳定状态下不再new节点，取出的值不留在空闲节点上
+void testNodeRecycling() {
+    cout << "=== 测试4: 节点循环使用 ===" << endl;
+
+    MpscQueue<shared_ptr<int>> queue;
+    auto value = make_shared<int>(42);
+    shared_ptr<int> out;
+    // 预热：第一批new出来的节点回收时补上一组
+    for (int i = 0; i < 8; ++i) {
+        queue.push(value);
+    }
+    while (queue.pop(out)) {}
+    uint64_t warm = queue.heapNodes();
+
+    for (int round = 0; round < 10000; ++round) {
+        for (int i = 0; i < 8; ++i) {
+            queue.push(value);
+        }
+        while (queue.pop(out)) {}
+    }
+    cout << "   new节点数: " << queue.heapNodes() << endl;
+    assert(queue.heapNodes() == warm);
+    out.reset();
+    assert(value.use_count() == 1);
+
+    // 多生产者下同样从空闲栈取节点：积压不超过256个时，节点全部来自空闲栈
+    MpscQueue<int> shared;
+    constexpr int kProducers = 4;
+    constexpr int kPerProducer = 50000;
+    vector<thread> producers;
+    atomic<int> pushed{0};
+    atomic<int> popped{0};
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&]() {
+            for (int i = 0; i < kPerProducer; ++i) {
+                while (pushed - popped > 256) {
+                    this_thread::yield();
+                }
+                ++pushed;
+                shared.push(i);
+            }
+        });
+    }
+    int item = 0;
+    while (popped < kProducers * kPerProducer) {
+        if (shared.pop(item)) {
+            ++popped;
+        }
+        else {
+            this_thread::yield();
+        }
+    }
+    for (auto& t : producers) {
+        t.join();
+    }
+    cout << "   多生产者new节点数: " << shared.heapNodes() << " / " << popped << endl;
+    assert(shared.heapNodes() < static_cast<uint64_t>(popped) / 100);
+
+    cout << "=== 测试4通过 ===\n" << endl;
+}
+
+int main() {
+    cout << "开始 MpscQueue 测试套件\n" << endl;
+
+    testFifo();
+    testMultiProducer();
+    testQueueInLoop();
+    testNodeRecycling();
+
+    cout << string(60, '=') << endl;
+    cout << "🎉 所有 MpscQueue 测试通过！" << endl;
+    cout << string(60, '=') << endl;
+    return 0;
+}
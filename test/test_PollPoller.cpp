@@ -0,0 +1,212 @@
+#include "./../EventLoop.h"
+#include "./../EventLoopThread.h"
+#include "./../Channel.h"
+#include "./../TcpConnection.h"
+#include <iostream>
+#include <future>
+#include <vector>
+#include <cassert>
+#include <cstdlib>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+// 测试1: 水平触发语义，每次回调只读1字节，数据没读完会继续通知
+void testLevelTriggered() {
+    cout << "=== 测试1: 水平触发 ===" << endl;
+
+    EventLoop loop;
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == 0);
+
+    Channel channel(&loop, fds[0]);
+    int reads = 0;
+    channel.setReadCallback([&](Timestamp) {
+        char c;
+        if (read(fds[0], &c, 1) == 1) {
+            ++reads;
+        }
+    });
+    channel.enableReading();
+    assert(write(fds[1], "abcdef", 6) == 6);
+
+    loop.runAfter(0.2, [&]() { loop.quit(); });
+    loop.loop();
+
+    cout << "   读回调次数: " << reads << endl;
+    assert(reads == 6);
+
+    channel.disableAll();
+    channel.remove();
+    close(fds[0]);
+    close(fds[1]);
+
+    cout << "=== 测试1通过 ===\n" << endl;
+}
+
+// 测试2: disableAll后fd取负被poll忽略，重新启用后恢复
+void testDisableAll() {
+    cout << "=== 测试2: 禁用与重新启用 ===" << endl;
+
+    EventLoop loop;
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == 0);
+
+    Channel channel(&loop, fds[0]);
+    int writes = 0;
+    int reads = 0;
+    channel.setWriteCallback([&]() {
+        if (++writes == 3) {
+            channel.disableWriting();
+        }
+    });
+    channel.setReadCallback([&](Timestamp) {
+        char buf[16];
+        reads += read(fds[0], buf, sizeof(buf)) > 0 ? 1 : 0;
+    });
+    channel.enableReading();
+    channel.enableWriting();
+
+    loop.runAfter(0.1, [&]() {
+        channel.disableAll();
+        assert(write(fds[1], "x", 1) == 1);
+    });
+    loop.runAfter(0.2, [&]() {
+        assert(reads == 0);
+        channel.enableReading();
+    });
+    loop.runAfter(0.3, [&]() { loop.quit(); });
+    loop.loop();
+
+    cout << "   写回调次数: " << writes << " 读回调次数: " << reads << endl;
+    assert(writes == 3);
+    assert(reads == 1);
+
+    channel.disableAll();
+    channel.remove();
+    close(fds[0]);
+    close(fds[1]);
+
+    cout << "=== 测试2通过 ===\n" << endl;
+}
+
+// 测试3: 删除中间的channel，最后一个channel被换到它的位置后仍能收到事件
+void testRemoveSwap() {
+    cout << "=== 测试3: 删除后交换下标 ===" << endl;
+
+    EventLoop loop;
+    constexpr int kCount = 4;
+    int fds[kCount][2];
+    vector<unique_ptr<Channel>> channels;
+    int reads[kCount] = {0};
+    for (int i = 0; i < kCount; ++i) {
+        assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds[i]) == 0);
+        channels.emplace_back(new Channel(&loop, fds[i][0]));
+        channels[i]->setReadCallback([&, i](Timestamp) {
+            char buf[16];
+            reads[i] += read(fds[i][0], buf, sizeof(buf)) > 0 ? 1 : 0;
+        });
+        channels[i]->enableReading();
+    }
+    // 最后一个channel先禁用，验证换位时能还原负数的fd
+    channels[kCount - 1]->disableAll();
+
+    int firstIndex = channels[1]->index();
+    channels[1]->disableAll();
+    channels[1]->remove();
+    assert(channels[1]->index() == -1);
+    assert(channels[kCount - 1]->index() == firstIndex);
+    assert(!loop.hasChannel(channels[1].get()));
+
+    channels[kCount - 1]->enableReading();
+    for (int i = 0; i < kCount; ++i) {
+        assert(write(fds[i][1], "x", 1) == 1);
+    }
+    loop.runAfter(0.1, [&]() { loop.quit(); });
+    loop.loop();
+
+    assert(reads[0] == 1);
+    assert(reads[1] == 0);
+    assert(reads[2] == 1);
+    assert(reads[3] == 1);
+
+    for (int i = 0; i < kCount; ++i) {
+        if (i != 1) {
+            channels[i]->disableAll();
+            channels[i]->remove();
+        }
+        close(fds[i][0]);
+        close(fds[i][1]);
+    }
+
+    cout << "=== 测试3通过 ===\n" << endl;
+}
+
+// 测试4: TcpConnection在poll后端上收发数据
+void testTcpConnectionEcho() {
+    cout << "=== 测试4: TcpConnection回显 ===" << endl;
+
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    InetAddress local("127.0.0.1", 0);
+    InetAddress peer("127.0.0.1", 0);
+    auto conn = make_shared<TcpConnection>(loop, string("polltest"), fds[0], local, peer);
+
+    promise<void> connected;
+    promise<void> closed;
+    conn->setConnectionCallback([&](const TcpConnectionPtr& c) {
+        if (c->connected()) {
+            connected.set_value();
+        }
+    });
+    conn->setMessageCallback([](const TcpConnectionPtr& c, Buffer* buf, Timestamp) {
+        c->send(buf->retrieveAllAsString());
+    });
+    conn->setCloseCallback([&](const TcpConnectionPtr& c) { closed.set_value(); });
+    loop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
+    assert(connected.get_future().wait_for(chrono::seconds(1)) == future_status::ready);
+
+    const string msg = "hello poll";
+    assert(write(fds[1], msg.data(), msg.size()) == static_cast<ssize_t>(msg.size()));
+    string echoed;
+    while (echoed.size() < msg.size()) {
+        char buf[64];
+        ssize_t n = read(fds[1], buf, sizeof(buf));
+        assert(n > 0);
+        echoed.append(buf, n);
+    }
+    assert(echoed == msg);
+
+    // 对端关闭：read返回0，走handleClose
+    shutdown(fds[1], SHUT_WR);
+    assert(closed.get_future().wait_for(chrono::seconds(1)) == future_status::ready);
+
+    promise<void> destroyed;
+    loop->runInLoop([&]() {
+        conn->connectDestroyed();
+        destroyed.set_value();
+    });
+    destroyed.get_future().wait();
+    close(fds[1]);
+
+    cout << "=== 测试4通过 ===\n" << endl;
+}
+
+int main() {
+    cout << "开始 PollPoller 测试套件\n" << endl;
+    setenv("MUDUO_USE_POLL", "1", 1);
+
+    testLevelTriggered();
+    testDisableAll();
+    testRemoveSwap();
+    testTcpConnectionEcho();
+
+    cout << string(60, '=') << endl;
+    cout << "🎉 所有 PollPoller 测试通过！" << endl;
+    cout << string(60, '=') << endl;
+    return 0;
+}
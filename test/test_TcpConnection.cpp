@@ -1,5 +1,6 @@
 #include "./../TcpConnection.h"
 #include "./../EventLoopThread.h"
+#include "./../EventLoop.h"
 #include "./../InetAddress.h"
 #include "./../Timestamp.h"
 #include <iostream>
@@ -10,6 +11,7 @@
 #include <vector>
 #include <sys/socket.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <string>
 #include <cstring>
 
@@ -368,6 +370,127 @@ bool test_send_from_other_thread()
     return true;
 }
 
+// 测试7: 设置空闲超时后没有读写，链接被时间轮关闭；有读写的链接不会被关闭
+bool test_idle_timeout_closes_connection()
+{
+    EventLoopThread t;
+    EventLoop* loop = t.startLoop();
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        cerr << "socketpair失败\n";
+        return false;
+    }
+
+    InetAddress local("127.0.0.1", 0);
+    InetAddress peer("127.0.0.1", 0);
+
+    auto conn = make_shared<TcpConnection>(loop, string("tcptest7"), fds[0], local, peer);
+
+    promise<void> closeProm;
+    auto closeF = closeProm.get_future();
+    atomic<bool> connected{false};
+    conn->setConnectionCallback([&](const TcpConnectionPtr& c){ connected = c->connected(); });
+    conn->setMessageCallback([](const TcpConnectionPtr&, Buffer* buf, Timestamp){ buf->retrieveAll(); });
+    conn->setCloseCallback([&](const TcpConnectionPtr& c){ closeProm.set_value(); });
+    conn->connectEstablished();
+    conn->setIdleTimeout(1.0);
+
+    // 持续有数据到达的1.5秒内链接不应该被关闭
+    for (int i = 0; i < 6; ++i) {
+        this_thread::sleep_for(chrono::milliseconds(250));
+        if (write(fds[1], "x", 1) != 1) {
+            close(fds[1]);
+            return false;
+        }
+    }
+    if (closeF.wait_for(chrono::milliseconds(0)) == future_status::ready) {
+        cerr << "有读写的链接被提前关闭\n";
+        close(fds[1]);
+        return false;
+    }
+
+    // 停止读写后在超时时间 + 一个tick内被关闭
+    bool ok = closeF.wait_for(chrono::seconds(3)) == future_status::ready && !connected;
+
+    close(fds[1]);
+    return ok;
+}
+
+// 测试8: 边沿触发模式回显大块数据，每次通知都要读写到EAGAIN，对端关闭后走handleClose
+bool test_edge_triggered_echo()
+{
+    EventLoopThread t;
+    EventLoop* loop = t.startLoop();
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        cerr << "socketpair失败\n";
+        return false;
+    }
+
+    InetAddress local("127.0.0.1", 0);
+    InetAddress peer("127.0.0.1", 0);
+
+    // 边沿触发依赖非阻塞socket读写到EAGAIN，和accept出来的链接一样
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    auto conn = make_shared<TcpConnection>(loop, string("tcptest8"), fds[0], local, peer);
+    conn->setEdgeTriggered(true);
+
+    promise<void> connProm;
+    promise<void> closeProm;
+    conn->setConnectionCallback([&](const TcpConnectionPtr& c){ if (c->connected()) connProm.set_value(); });
+    conn->setMessageCallback([](const TcpConnectionPtr& c, Buffer* buf, Timestamp){ c->send(buf->retrieveAllAsString()); });
+    conn->setCloseCallback([&](const TcpConnectionPtr& c){ closeProm.set_value(); });
+    loop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
+    if (connProm.get_future().wait_for(chrono::seconds(1)) != future_status::ready) {
+        close(fds[1]);
+        return false;
+    }
+
+    // 1MB数据：超过socket缓冲区，回显时一定会出现部分写
+    const size_t total = 1024 * 1024;
+    string msg(total, '\0');
+    for (size_t i = 0; i < total; ++i) {
+        msg[i] = static_cast<char>('a' + i % 26);
+    }
+    thread writer([&]() {
+        size_t written = 0;
+        while (written < total) {
+            ssize_t n = write(fds[1], msg.data() + written, total - written);
+            if (n <= 0) break;
+            written += n;
+        }
+    });
+    string echoed;
+    while (echoed.size() < total) {
+        char buf[65536];
+        ssize_t n = read(fds[1], buf, sizeof(buf));
+        if (n <= 0) break;
+        echoed.append(buf, n);
+    }
+    writer.join();
+    if (echoed != msg) {
+        cerr << "回显数据不一致，收到" << echoed.size() << "字节\n";
+        close(fds[1]);
+        return false;
+    }
+
+    ::shutdown(fds[1], SHUT_WR);
+    bool ok = closeProm.get_future().wait_for(chrono::seconds(1)) == future_status::ready;
+
+    promise<void> destroyed;
+    loop->runInLoop([&]() {
+        conn->connectDestroyed();
+        destroyed.set_value();
+    });
+    destroyed.get_future().wait();
+    close(fds[1]);
+    // 链接销毁后从所属loop的负载统计中扣除
+    ok = ok && loop->connectionCount() == 0 && loop->bufferedBytes() == 0;
+    return ok;
+}
+
 int main()
 {
     cout << "开始 TcpConnection 测试套件\n";
@@ -378,6 +501,8 @@ int main()
     run_test("connectDestroyed -> connectionCallback & disconnect", [](){ return test_connect_destroyed_triggers_connection_callback(); });
     run_test("send after shutdown -> no delivery", [](){ return test_send_after_shutdown_no_delivery(); });
     run_test("send from other thread -> delivery", [](){ return test_send_from_other_thread(); });
+    run_test("idle timeout -> close", [](){ return test_idle_timeout_closes_connection(); });
+    run_test("edge triggered -> echo", [](){ return test_edge_triggered_echo(); });
 
     cout << "\\n测试汇总:\\n";
     int pass = 0;
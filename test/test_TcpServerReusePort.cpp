@@ -0,0 +1,193 @@
+#include "./../TcpServer.h"
+#include "./../TcpConnection.h"
+#include "./../EventLoop.h"
+#include "./../InetAddress.h"
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <set>
+#include <atomic>
+#include <cassert>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+using namespace std;
+
+// 阻塞的客户端：连接、发送、等待回显
+static bool echoOnce(uint16_t port, const string& msg) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return false;
+    }
+    if (write(fd, msg.data(), msg.size()) != static_cast<ssize_t>(msg.size())) {
+        close(fd);
+        return false;
+    }
+    string echoed;
+    while (echoed.size() < msg.size()) {
+        char buf[64];
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) break;
+        echoed.append(buf, n);
+    }
+    close(fd);
+    return echoed == msg;
+}
+
+// 测试1: 每个loop一个SO_REUSEPORT监听器，链接在各个子loop中accept并建立，不经过baseLoop
+void testAcceptorPerLoop() {
+    cout << "=== 测试1: 每个loop一个监听器 ===" << endl;
+
+    const uint16_t port = 18091;
+    const int kThreads = 4;
+    const int kClients = 64;
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress("127.0.0.1", port), "reuseport");
+    server.setThreadNum(kThreads);
+    server.setAcceptorPerLoop(true);
+
+    mutex mtx;
+    set<EventLoop*> usedLoops;
+    atomic<int> connected{0};
+    atomic<int> disconnected{0};
+    atomic<bool> wrongThread{false};
+    server.setConnectionCallback([&](const TcpConnectionPtr& conn) {
+        if (!conn->getLoop()->isInLoopThread() || conn->getLoop() == &loop) {
+            wrongThread = true;
+        }
+        if (conn->connected()) {
+            ++connected;
+            lock_guard<mutex> lock(mtx);
+            usedLoops.insert(conn->getLoop());
+        } else {
+            ++disconnected;
+        }
+    });
+    server.setMessageCallback([](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+        conn->send(buf->retrieveAllAsString());
+    });
+    server.start();
+
+    atomic<int> ok{0};
+    thread clients([&]() {
+        for (int i = 0; i < kClients; ++i) {
+            if (echoOnce(port, "hello" + to_string(i))) {
+                ++ok;
+            }
+        }
+        // 等待服务端处理完所有对端关闭
+        for (int i = 0; i < 100 && disconnected < kClients; ++i) {
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        loop.quit();
+    });
+    loop.loop();
+    clients.join();
+
+    cout << "   回显成功: " << ok << "/" << kClients << " 使用的loop数: " << usedLoops.size() << endl;
+    assert(ok == kClients);
+    assert(connected == kClients);
+    assert(disconnected == kClients);
+    assert(!wrongThread);
+    // 内核按四元组哈希分配，64个链接几乎不可能全部落在同一个loop上
+    assert(usedLoops.size() > 1);
+
+    cout << "=== 测试1通过 ===\n" << endl;
+}
+
+// 测试2: baseLoop已经退出（还没析构）时在其他线程析构TcpServer，不再等待不会执行的任务
+void testDestroyAfterLoopExit() {
+    cout << "=== 测试2: loop退出之后析构TcpServer ===" << endl;
+
+    const uint16_t port = 18092;
+    mutex mtx;
+    condition_variable cond;
+    EventLoop* loop = nullptr;
+    bool exited = false;
+    bool release = false;
+    // baseLoop在自己的线程中运行，退出之后等到TcpServer析构完才析构
+    thread loopThread([&]() {
+        EventLoop threadLoop;
+        {
+            lock_guard<mutex> lock(mtx);
+            loop = &threadLoop;
+        }
+        cond.notify_all();
+        threadLoop.loop();
+        unique_lock<mutex> lock(mtx);
+        exited = true;
+        cond.notify_all();
+        cond.wait(lock, [&]() { return release; });
+    });
+    {
+        unique_lock<mutex> lock(mtx);
+        cond.wait(lock, [&]() { return loop != nullptr; });
+    }
+
+    atomic<int> connected{0};
+    int client = -1;
+    {
+        auto server = make_unique<TcpServer>(loop, InetAddress("127.0.0.1", port), "reuseport-exit");
+        server->setAcceptorPerLoop(true);
+        server->setConnectionCallback([&](const TcpConnectionPtr& conn) {
+            if (conn->connected()) {
+                ++connected;
+            }
+        });
+        server->setMessageCallback([](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+            conn->send(buf->retrieveAllAsString());
+        });
+        server->start();
+        assert(echoOnce(port, "before exit"));
+
+        // 留一个链接在链接表中
+        client = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        assert(connect(client, (sockaddr*)&addr, sizeof(addr)) == 0);
+        for (int i = 0; i < 100 && connected < 2; ++i) {
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        assert(connected == 2);
+
+        loop->quit();
+        {
+            unique_lock<mutex> lock(mtx);
+            cond.wait(lock, [&]() { return exited; });
+        }
+        // loop不会再执行任务：监听器和链接在当前线程清理
+        server.reset();
+    }
+    {
+        lock_guard<mutex> lock(mtx);
+        release = true;
+    }
+    cond.notify_all();
+    loopThread.join();
+    close(client);
+
+    cout << "=== 测试2通过 ===\n" << endl;
+}
+
+int main() {
+    cout << "开始 TcpServer SO_REUSEPORT 测试套件\n" << endl;
+
+    testAcceptorPerLoop();
+    testDestroyAfterLoopExit();
+
+    cout << string(60, '=') << endl;
+    cout << "🎉 所有 TcpServer SO_REUSEPORT 测试通过！" << endl;
+    cout << string(60, '=') << endl;
+    return 0;
+}
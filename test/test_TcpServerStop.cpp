@@ -0,0 +1,267 @@
+#include "./../TcpServer.h"
+#include "./../TcpConnection.h"
+#include "./../EventLoop.h"
+#include "./../InetAddress.h"
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <mutex>
+#include <cassert>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+using namespace std;
+
+static int connectTo(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 读到EOF或者出错为止，返回读到的字节数
+static size_t readUntilEof(int fd) {
+    size_t total = 0;
+    char buf[65536];
+    while (true) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) break;
+        total += n;
+    }
+    return total;
+}
+
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// 测试1: 停止时发送缓冲区里的数据全部发完，然后半关闭，对端关闭后loop退出；停止之后不再接受新链接
+void testGracefulDrain() {
+    cout << "=== 测试1: 排空发送缓冲区后半关闭 ===" << endl;
+
+    const uint16_t port = 18101;
+    const size_t kPayload = 4 * 1024 * 1024;
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress("127.0.0.1", port), "drain", TcpServer::kNoReusePort);
+    server.setThreadNum(2);
+    atomic<int> connected{0};
+    atomic<int> disconnected{0};
+    server.setConnectionCallback([&](const TcpConnectionPtr& conn) {
+        if (conn->connected()) {
+            // 对端还没开始读，大部分数据会留在outputBuffer_中
+            conn->send(string(kPayload, 'x'));
+            ++connected;
+        } else {
+            ++disconnected;
+        }
+    });
+    server.start();
+
+    atomic<size_t> received{0};
+    atomic<bool> stopped{false};
+    chrono::steady_clock::time_point stopAt;
+    thread client([&]() {
+        int fd = connectTo(port);
+        assert(fd >= 0);
+        while (connected == 0) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        stopAt = chrono::steady_clock::now();
+        server.stop(5.0, [&]() {
+            stopped = true;
+            loop.quit();
+        });
+        this_thread::sleep_for(chrono::milliseconds(50));
+        // 监听socket已经关闭
+        int late = connectTo(port);
+        assert(late < 0);
+        // 还没有读完数据，服务端不能结束
+        assert(!stopped);
+        received = readUntilEof(fd);
+        close(fd);
+    });
+    loop.loop();
+    client.join();
+
+    cout << "   收到: " << received << "/" << kPayload << " 停止用时: " << secondsSince(stopAt) * 1000 << "ms" << endl;
+    assert(stopped);
+    assert(received == kPayload);
+    assert(disconnected == 1);
+    assert(secondsSince(stopAt) < 2.0);
+
+    cout << "=== 测试1通过 ===\n" << endl;
+}
+
+// 测试2: 对端一直不读也不关闭，超时之后强制关闭
+void testDrainDeadline() {
+    cout << "=== 测试2: 排空超时强制关闭 ===" << endl;
+
+    const uint16_t port = 18102;
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress("127.0.0.1", port), "deadline", TcpServer::kNoReusePort);
+    server.setThreadNum(2);
+    atomic<int> connected{0};
+    atomic<int> disconnected{0};
+    server.setConnectionCallback([&](const TcpConnectionPtr& conn) {
+        if (conn->connected()) {
+            conn->send(string(8 * 1024 * 1024, 'y'));
+            ++connected;
+        } else {
+            ++disconnected;
+        }
+    });
+    server.start();
+
+    const int kClients = 4;
+    vector<int> fds;
+    for (int i = 0; i < kClients; ++i) {
+        fds.push_back(connectTo(port));
+        assert(fds.back() >= 0);
+    }
+    chrono::steady_clock::time_point stopAt;
+    thread stopper([&]() {
+        while (connected < kClients) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        stopAt = chrono::steady_clock::now();
+        server.stop(0.3, [&]() { loop.quit(); });
+    });
+    loop.loop();
+    stopper.join();
+
+    double elapsed = secondsSince(stopAt);
+    cout << "   停止用时: " << elapsed * 1000 << "ms 断开: " << disconnected << endl;
+    assert(elapsed >= 0.25);
+    assert(elapsed < 2.0);
+    assert(disconnected == kClients);
+    for (int fd : fds) {
+        close(fd);
+    }
+
+    cout << "=== 测试2通过 ===\n" << endl;
+}
+
+// 测试3: 每个loop一个监听器时，各个loop自己排空自己的链接
+void testDrainAcceptorPerLoop() {
+    cout << "=== 测试3: 每个loop一个监听器时停止 ===" << endl;
+
+    const uint16_t port = 18103;
+    const int kClients = 16;
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress("127.0.0.1", port), "drain-reuseport");
+    server.setThreadNum(3);
+    server.setAcceptorPerLoop(true);
+    atomic<int> connected{0};
+    atomic<int> disconnected{0};
+    server.setConnectionCallback([&](const TcpConnectionPtr& conn) {
+        if (conn->connected()) {
+            ++connected;
+        } else {
+            ++disconnected;
+        }
+    });
+    server.start();
+
+    atomic<int> eofs{0};
+    thread clients([&]() {
+        vector<int> fds;
+        for (int i = 0; i < kClients; ++i) {
+            fds.push_back(connectTo(port));
+            assert(fds.back() >= 0);
+        }
+        while (connected < kClients) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        server.stop(5.0, [&]() { loop.quit(); });
+        // 服务端半关闭：客户端读到EOF后关闭
+        for (int fd : fds) {
+            readUntilEof(fd);
+            ++eofs;
+            close(fd);
+        }
+    });
+    loop.loop();
+    clients.join();
+
+    cout << "   EOF: " << eofs << " 断开: " << disconnected << endl;
+    assert(eofs == kClients);
+    assert(disconnected == kClients);
+
+    cout << "=== 测试3通过 ===\n" << endl;
+}
+
+// 测试4: 排空超时后，强制关闭任务在某个loop中排队时其他loop已经排空，停止流程结束之后这个任务才执行
+void testForceCloseOnSlowLoop() {
+    cout << "=== 测试4: 强制关闭任务晚于停止流程执行 ===" << endl;
+
+    const uint16_t port = 18104;
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress("127.0.0.1", port), "slow-loop");
+    server.setThreadNum(2);
+    server.setAcceptorPerLoop(true);
+    mutex loopsMutex;
+    vector<EventLoop*> ioLoops;
+    server.setThreadInitCallback([&](EventLoop* ioLoop) {
+        lock_guard<mutex> lock(loopsMutex);
+        ioLoops.push_back(ioLoop);
+    });
+    atomic<EventLoop*> connLoop{nullptr};
+    server.setConnectionCallback([&](const TcpConnectionPtr& conn) {
+        if (conn->connected()) {
+            connLoop = conn->getLoop();
+        }
+    });
+    server.start();
+
+    // 对端不读也不关闭，只能等超时强制关闭
+    int fd = connectTo(port);
+    assert(fd >= 0);
+    atomic<bool> stopped{false};
+    thread stopper([&]() {
+        while (connLoop == nullptr) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        EventLoop* idle = ioLoops[0] == connLoop ? ioLoops[1] : ioLoops[0];
+        server.stop(0.2, [&]() {
+            stopped = true;
+            loop.quit();
+        });
+        // 没有链接的loop已经排空；让它在超时的时候正忙，强制关闭任务排在后面
+        this_thread::sleep_for(chrono::milliseconds(50));
+        idle->runInLoop([]() { this_thread::sleep_for(chrono::milliseconds(400)); });
+    });
+    loop.loop();
+    stopper.join();
+    close(fd);
+
+    assert(stopped);
+
+    cout << "=== 测试4通过 ===\n" << endl;
+}
+
+int main() {
+    cout << "开始 TcpServer 停止测试套件\n" << endl;
+
+    testGracefulDrain();
+    testDrainDeadline();
+    testDrainAcceptorPerLoop();
+    testForceCloseOnSlowLoop();
+
+    cout << string(60, '=') << endl;
+    cout << "🎉 所有 TcpServer 停止测试通过！" << endl;
+    cout << string(60, '=') << endl;
+    return 0;
+}
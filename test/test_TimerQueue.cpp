@@ -0,0 +1,136 @@
+#include "./../EventLoop.h"
+#include "./../EventLoopThread.h"
+#include "./../Timestamp.h"
+#include "./../TimerId.h"
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <cassert>
+
+using namespace std;
+
+// 测试1: runAfter按到期时间顺序执行
+void testRunAfterOrder() {
+    cout << "=== 测试1: runAfter执行顺序 ===" << endl;
+
+    EventLoop loop;
+    vector<int> order;
+
+    loop.runAfter(0.3, [&]() { order.push_back(3); });
+    loop.runAfter(0.1, [&]() { order.push_back(1); });
+    loop.runAfter(0.2, [&]() { order.push_back(2); });
+    loop.runAfter(0.4, [&]() { loop.quit(); });
+
+    Timestamp start(Timestamp::now());
+    loop.loop();
+    double elapsed = timeDifference(Timestamp::now(), start);
+
+    cout << "   耗时: " << elapsed << "s" << endl;
+    assert(order.size() == 3);
+    assert(order[0] == 1 && order[1] == 2 && order[2] == 3);
+    assert(elapsed >= 0.35 && elapsed < 1.0);
+
+    cout << "=== 测试1通过 ===\n" << endl;
+}
+
+// 测试2: runEvery重复执行，在回调中取消自己
+void testRunEveryAndCancelSelf() {
+    cout << "=== 测试2: runEvery与回调中取消 ===" << endl;
+
+    EventLoop loop;
+    int count = 0;
+    TimerId every;
+    every = loop.runEvery(0.05, [&]() {
+        ++count;
+        if (count == 5) {
+            loop.cancel(every);
+        }
+    });
+    loop.runAfter(0.5, [&]() { loop.quit(); });
+    loop.loop();
+
+    cout << "   执行次数: " << count << endl;
+    assert(count == 5);
+
+    cout << "=== 测试2通过 ===\n" << endl;
+}
+
+// 测试3: 取消还未到期的定时器
+void testCancelBeforeExpire() {
+    cout << "=== 测试3: 取消未到期定时器 ===" << endl;
+
+    EventLoop loop;
+    bool fired = false;
+    TimerId id = loop.runAfter(0.1, [&]() { fired = true; });
+    loop.cancel(id);
+    loop.runAfter(0.2, [&]() { loop.quit(); });
+    loop.loop();
+
+    assert(!fired);
+
+    cout << "=== 测试3通过 ===\n" << endl;
+}
+
+// 测试4: 跨线程添加、取消定时器
+void testCrossThread() {
+    cout << "=== 测试4: 跨线程添加定时器 ===" << endl;
+
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+
+    atomic<int> fired{0};
+    atomic<pid_t> firedTid{0};
+    loop->runAfter(0.05, [&]() {
+        firedTid = CurrentThread::tid();
+        fired++;
+    });
+    TimerId canceled = loop->runAfter(0.1, [&]() { fired += 100; });
+    loop->cancel(canceled);
+
+    this_thread::sleep_for(chrono::milliseconds(300));
+    cout << "   回调执行线程: " << firedTid << " 主线程: " << CurrentThread::tid() << endl;
+    assert(fired == 1);
+    assert(firedTid != CurrentThread::tid());
+
+    cout << "=== 测试4通过 ===\n" << endl;
+}
+
+// 测试5: 跨线程添加的定时器还没插入loop就退出，定时器随任务一起释放
+void testQueuedTimerFreed() {
+    cout << "=== 测试5: 未插入的定时器在loop析构时释放 ===" << endl;
+
+    auto token = make_shared<int>(0);
+    weak_ptr<int> weak = token;
+    {
+        EventLoop loop;
+        // loop没有运行：添加操作留在任务队列中
+        thread adder([&loop, token]() {
+            loop.runAfter(10.0, [token]() {});
+        });
+        adder.join();
+        token.reset();
+        assert(!weak.expired());
+    }
+    // 回调随定时器一起析构
+    assert(weak.expired());
+
+    cout << "=== 测试5通过 ===\n" << endl;
+}
+
+int main() {
+    cout << "开始 TimerQueue 测试套件\n" << endl;
+
+    testRunAfterOrder();
+    testRunEveryAndCancelSelf();
+    testCancelBeforeExpire();
+    testCrossThread();
+    testQueuedTimerFreed();
+
+    cout << string(60, '=') << endl;
+    cout << "🎉 所有 TimerQueue 测试通过！" << endl;
+    cout << string(60, '=') << endl;
+    return 0;
+}
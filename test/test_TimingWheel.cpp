@@ -0,0 +1,132 @@
+#include "./../EventLoop.h"
+#include "./../TimingWheel.h"
+#include "./../Timestamp.h"
+#include <iostream>
+#include <cassert>
+#include <memory>
+
+using namespace std;
+
+// 测试1: 没有touch的条目按时到期
+void testExpire() {
+    cout << "=== 测试1: 条目到期 ===" << endl;
+
+    EventLoop loop;
+    TimingWheel wheel(&loop, 0.02, 8);
+    Timestamp start(Timestamp::now());
+    double elapsed = 0;
+    TimingWheel::Entry* entry = nullptr;
+    entry = wheel.add(0.1, [&]() {
+        elapsed = timeDifference(Timestamp::now(), start);
+        wheel.remove(entry);
+        loop.quit();
+    });
+    loop.runAfter(1.0, [&]() { loop.quit(); });
+    loop.loop();
+
+    cout << "   到期耗时: " << elapsed << "s" << endl;
+    assert(elapsed >= 0.1 && elapsed < 0.3);
+    assert(wheel.size() == 0);
+
+    cout << "=== 测试1通过 ===\n" << endl;
+}
+
+// 测试2: 持续touch的条目不会到期，停止touch后到期
+void testTouch() {
+    cout << "=== 测试2: touch推迟到期 ===" << endl;
+
+    EventLoop loop;
+    TimingWheel wheel(&loop, 0.02, 8);
+    bool expired = false;
+    TimingWheel::Entry* entry = nullptr;
+    entry = wheel.add(0.1, [&]() {
+        expired = true;
+        entry = nullptr;
+    });
+
+    TimerId toucher = loop.runEvery(0.03, [&]() {
+        if (entry) {
+            wheel.touch(entry);
+        }
+    });
+    loop.runAfter(0.4, [&]() {
+        assert(!expired);
+        loop.cancel(toucher);
+    });
+    loop.runAfter(0.7, [&]() { loop.quit(); });
+    loop.loop();
+
+    // 到期的条目由时间轮释放，tick定时器随之停止
+    assert(expired);
+    assert(wheel.size() == 0);
+
+    cout << "=== 测试2通过 ===\n" << endl;
+}
+
+// 测试3: 超时时间超过一圈，remove后不再回调
+void testMultiRoundAndRemove() {
+    cout << "=== 测试3: 多圈条目与remove ===" << endl;
+
+    EventLoop loop;
+    // 一圈只有4*0.02=0.08秒
+    TimingWheel wheel(&loop, 0.02, 4);
+    Timestamp start(Timestamp::now());
+    double elapsed = 0;
+    bool removedFired = false;
+    TimingWheel::Entry* longEntry = nullptr;
+    longEntry = wheel.add(0.3, [&]() {
+        elapsed = timeDifference(Timestamp::now(), start);
+        wheel.remove(longEntry);
+    });
+    TimingWheel::Entry* removed = wheel.add(0.1, [&]() { removedFired = true; });
+    wheel.remove(removed);
+
+    loop.runAfter(0.6, [&]() { loop.quit(); });
+    loop.loop();
+
+    cout << "   到期耗时: " << elapsed << "s" << endl;
+    assert(elapsed >= 0.3 && elapsed < 0.5);
+    assert(!removedFired);
+    assert(wheel.size() == 0);
+
+    cout << "=== 测试3通过 ===\n" << endl;
+}
+
+// 测试4: 持有者已经不在的条目到期后也被释放，时间轮排空
+void testExpireWithoutOwner() {
+    cout << "=== 测试4: 无人持有的条目到期释放 ===" << endl;
+
+    EventLoop loop;
+    TimingWheel wheel(&loop, 0.02, 8);
+    int fired = 0;
+    for (int i = 0; i < 10; ++i) {
+        // 和TcpConnection一样：弱引用已经失效，回调什么也不做，也不remove
+        weak_ptr<int> owner = make_shared<int>(i);
+        wheel.add(0.05, [owner, &fired]() {
+            ++fired;
+            assert(!owner.lock());
+        });
+    }
+    assert(wheel.size() == 10);
+    loop.runAfter(0.3, [&]() { loop.quit(); });
+    loop.loop();
+
+    assert(fired == 10);
+    assert(wheel.size() == 0);
+
+    cout << "=== 测试4通过 ===\n" << endl;
+}
+
+int main() {
+    cout << "开始 TimingWheel 测试套件\n" << endl;
+
+    testExpire();
+    testTouch();
+    testMultiRoundAndRemove();
+    testExpireWithoutOwner();
+
+    cout << string(60, '=') << endl;
+    cout << "🎉 所有 TimingWheel 测试通过！" << endl;
+    cout << string(60, '=') << endl;
+    return 0;
+}